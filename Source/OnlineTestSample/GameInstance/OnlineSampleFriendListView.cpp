@@ -0,0 +1,322 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "OnlineSampleFriendListView.h"
+
+#include "Algo/BinarySearch.h"
+
+UOnlineSampleFriendListView* UOnlineSampleFriendListView::CreateFriendListView(UOnlineSampleOnlineSubsystem* OnlineSubsystem, EFriendListSortMode InSortMode, const FString& InFilterText)
+{
+	if(!OnlineSubsystem)
+	{
+		return nullptr;
+	}
+
+	UOnlineSampleFriendListView* View = NewObject<UOnlineSampleFriendListView>(OnlineSubsystem);
+	View->Initialize(OnlineSubsystem, InSortMode, InFilterText);
+	return View;
+}
+
+void UOnlineSampleFriendListView::Initialize(UOnlineSampleOnlineSubsystem* InSubsystem, EFriendListSortMode InSortMode, const FString& InFilterText)
+{
+	check(InSubsystem);
+	
+	Subsystem = InSubsystem;
+	SortMode = InSortMode;
+	FilterText = InFilterText;
+
+	FriendRosterChangedHandle = InSubsystem->OnFriendRosterChangedEvent.AddUObject(this, &ThisClass::HandleFriendRosterChanged);
+	FriendPresenceUpdatedHandle = InSubsystem->OnFriendPresenceUpdatedEvent.AddUObject(this, &ThisClass::HandleFriendPresenceUpdated);
+	FriendLastPlayedUpdatedHandle = InSubsystem->OnFriendLastPlayedUpdatedEvent.AddUObject(this, &ThisClass::HandleFriendLastPlayedUpdated);
+
+	Rebuild();
+}
+
+void UOnlineSampleFriendListView::BeginDestroy()
+{
+	if(UOnlineSampleOnlineSubsystem* OnlineSubsystem = Subsystem.Get())
+	{
+		OnlineSubsystem->OnFriendRosterChangedEvent.Remove(FriendRosterChangedHandle);
+		OnlineSubsystem->OnFriendPresenceUpdatedEvent.Remove(FriendPresenceUpdatedHandle);
+		OnlineSubsystem->OnFriendLastPlayedUpdatedEvent.Remove(FriendLastPlayedUpdatedHandle);
+	}
+	
+	Super::BeginDestroy();
+}
+
+void UOnlineSampleFriendListView::SetSortMode(EFriendListSortMode InSortMode)
+{
+	if(SortMode != InSortMode)
+	{
+		SortMode = InSortMode;
+		Rebuild();
+		NotifyViewChanged(0);
+	}
+}
+
+void UOnlineSampleFriendListView::SetFilterText(const FString& InFilterText)
+{
+	if(!FilterText.Equals(InFilterText, ESearchCase::CaseSensitive))
+	{
+		FilterText = InFilterText;
+		Rebuild();
+		NotifyViewChanged(0);
+	}
+}
+
+bool UOnlineSampleFriendListView::GetFriendAt(int32 Index, FBlueprintFriendInfo& OutFriendInfo) const
+{
+	const UOnlineSampleOnlineSubsystem* OnlineSubsystem = Subsystem.Get();
+	if(!OnlineSubsystem || !SortedHandles.IsValidIndex(Index))
+	{
+		return false;
+	}
+
+	const FOnlineSampleFriendRoster& Roster = OnlineSubsystem->GetFriendRoster();
+	const int32 Slot = Roster.FindSlot(SortedHandles[Index]);
+	if(Slot == INDEX_NONE)
+	{
+		return false;
+	}
+	
+	OutFriendInfo = FBlueprintFriendInfo(Roster, Slot);
+	return true;
+}
+
+void UOnlineSampleFriendListView::GetRange(int32 First, int32 Count, TArray<FBlueprintFriendInfo>& OutFriendInfos) const
+{
+	OutFriendInfos.Reset();
+	
+	const UOnlineSampleOnlineSubsystem* OnlineSubsystem = Subsystem.Get();
+	First = FMath::Max(First, 0);
+	const int32 Last = FMath::Min(First + FMath::Max(Count, 0), SortedHandles.Num());
+	if(!OnlineSubsystem || First >= Last)
+	{
+		return;
+	}
+
+	const FOnlineSampleFriendRoster& Roster = OnlineSubsystem->GetFriendRoster();
+	OutFriendInfos.Reserve(Last - First);
+	for(int32 Index = First; Index < Last; ++Index)
+	{
+		const int32 Slot = Roster.FindSlot(SortedHandles[Index]);
+		if(Slot != INDEX_NONE)
+		{
+			OutFriendInfos.Emplace(Roster, Slot);
+		}
+	}
+}
+
+int32 UOnlineSampleFriendListView::IndexOfFriend(int32 FriendId) const
+{
+	const FSortKey* Key = SortKeys.Find(FriendId);
+	return Key ? LowerBound(*Key) : INDEX_NONE;
+}
+
+bool UOnlineSampleFriendListView::IsLess(const FSortKey& A, const FSortKey& B) const
+{
+	if(A.Rank != B.Rank)
+	{
+		return A.Rank < B.Rank;
+	}
+	if(A.LastPlayedTime != B.LastPlayedTime)
+	{
+		return A.LastPlayedTime > B.LastPlayedTime;
+	}
+	if(const int32 NameOrder = A.Name.Compare(B.Name, ESearchCase::IgnoreCase))
+	{
+		return NameOrder < 0;
+	}
+	// 핸들까지 보면 키가 겹치지 않으므로 이진 탐색이 항상 정확한 위치를 찾습니다.
+	return A.Handle < B.Handle;
+}
+
+UOnlineSampleFriendListView::FSortKey UOnlineSampleFriendListView::MakeSortKey(int32 FriendId) const
+{
+	const UOnlineSampleOnlineSubsystem* OnlineSubsystem = Subsystem.Get();
+	const FOnlineSampleFriendRoster& Roster = OnlineSubsystem->GetFriendRoster();
+	const int32 Slot = Roster.FindSlot(FriendId);
+	
+	FSortKey Key;
+	Key.Handle = FriendId;
+	Key.Name = Roster.GetNickname(Slot).IsEmpty() ? Roster.GetDisplayName(Slot) : Roster.GetNickname(Slot);
+
+	switch(SortMode)
+	{
+	case EFriendListSortMode::OnlineThenName:
+		{
+			FBlueprintPresenceInfo PresenceInfo;
+			if(!OnlineSubsystem->GetFriendPresence(FriendId, PresenceInfo))
+			{
+				Key.Rank = 2;
+			}
+			else if(PresenceInfo.Status == EBlueprintPresenceStatus::Online)
+			{
+				Key.Rank = 0;
+			}
+			else if(PresenceInfo.Status == EBlueprintPresenceStatus::Offline || PresenceInfo.Status == EBlueprintPresenceStatus::Unknown)
+			{
+				Key.Rank = 2;
+			}
+			else
+			{
+				// 자리 비움, 방해 금지는 온라인과 오프라인 사이에 둡니다.
+				Key.Rank = 1;
+			}
+		}
+		break;
+	case EFriendListSortMode::RecentlyPlayed:
+		Key.LastPlayedTime = OnlineSubsystem->GetFriendLastPlayedTime(FriendId);
+		break;
+	default:
+		break;
+	}
+	return Key;
+}
+
+bool UOnlineSampleFriendListView::PassesFilter(int32 Slot) const
+{
+	if(FilterText.IsEmpty())
+	{
+		return true;
+	}
+
+	const FOnlineSampleFriendRoster& Roster = Subsystem->GetFriendRoster();
+	return Roster.GetDisplayName(Slot).Contains(FilterText) || Roster.GetNickname(Slot).Contains(FilterText);
+}
+
+int32 UOnlineSampleFriendListView::LowerBound(const FSortKey& Key) const
+{
+	const int32 Index = Algo::LowerBoundBy(SortedHandles, Key,
+		[this](int32 Handle) -> const FSortKey& { return SortKeys.FindChecked(Handle); },
+		[this](const FSortKey& A, const FSortKey& B) { return IsLess(A, B); });
+	return SortedHandles.IsValidIndex(Index) && SortedHandles[Index] == Key.Handle ? Index : INDEX_NONE;
+}
+
+int32 UOnlineSampleFriendListView::InsertFriend(int32 FriendId)
+{
+	const int32 Slot = Subsystem->GetFriendRoster().FindSlot(FriendId);
+	if(Slot == INDEX_NONE || SortKeys.Contains(FriendId) || !PassesFilter(Slot))
+	{
+		return INDEX_NONE;
+	}
+
+	const FSortKey& Key = SortKeys.Add(FriendId, MakeSortKey(FriendId));
+	const int32 Index = Algo::LowerBoundBy(SortedHandles, Key,
+		[this](int32 Handle) -> const FSortKey& { return SortKeys.FindChecked(Handle); },
+		[this](const FSortKey& A, const FSortKey& B) { return IsLess(A, B); });
+	SortedHandles.Insert(FriendId, Index);
+	return Index;
+}
+
+int32 UOnlineSampleFriendListView::RemoveFriend(int32 FriendId)
+{
+	const FSortKey* Key = SortKeys.Find(FriendId);
+	if(!Key)
+	{
+		return INDEX_NONE;
+	}
+
+	// 저장해 둔 예전 키로 찾으므로 이름이나 상태가 이미 바뀌었어도 됩니다.
+	const int32 Index = LowerBound(*Key);
+	if(Index != INDEX_NONE)
+	{
+		SortedHandles.RemoveAt(Index);
+	}
+	SortKeys.Remove(FriendId);
+	return Index;
+}
+
+int32 UOnlineSampleFriendListView::RefreshFriend(int32 FriendId)
+{
+	const int32 RemovedIndex = RemoveFriend(FriendId);
+	const int32 InsertedIndex = InsertFriend(FriendId);
+	if(RemovedIndex == INDEX_NONE || InsertedIndex == INDEX_NONE)
+	{
+		return RemovedIndex == INDEX_NONE ? InsertedIndex : RemovedIndex;
+	}
+	return FMath::Min(RemovedIndex, InsertedIndex);
+}
+
+void UOnlineSampleFriendListView::Rebuild()
+{
+	SortedHandles.Reset();
+	SortKeys.Reset();
+
+	const UOnlineSampleOnlineSubsystem* OnlineSubsystem = Subsystem.Get();
+	if(!OnlineSubsystem)
+	{
+		return;
+	}
+
+	const FOnlineSampleFriendRoster& Roster = OnlineSubsystem->GetFriendRoster();
+	SortedHandles.Reserve(Roster.Num());
+	for(int32 Slot = 0; Slot < Roster.GetSlotCapacity(); ++Slot)
+	{
+		if(Roster.IsValidSlot(Slot) && PassesFilter(Slot))
+		{
+			const int32 FriendId = Roster.GetHandle(Slot);
+			SortKeys.Add(FriendId, MakeSortKey(FriendId));
+			SortedHandles.Add(FriendId);
+		}
+	}
+	
+	SortedHandles.Sort([this](int32 A, int32 B) { return IsLess(SortKeys.FindChecked(A), SortKeys.FindChecked(B)); });
+}
+
+void UOnlineSampleFriendListView::HandleFriendRosterChanged(const FBlueprintFriendRosterDelta& RosterDelta)
+{
+	int32 FirstChangedIndex = INDEX_NONE;
+	auto Track = [&FirstChangedIndex](int32 Index)
+	{
+		if(Index != INDEX_NONE)
+		{
+			FirstChangedIndex = FirstChangedIndex == INDEX_NONE ? Index : FMath::Min(FirstChangedIndex, Index);
+		}
+	};
+
+	for(int32 FriendId : RosterDelta.RemovedFriendIds)
+	{
+		Track(RemoveFriend(FriendId));
+	}
+	for(int32 FriendId : RosterDelta.ChangedFriendIds)
+	{
+		Track(RefreshFriend(FriendId));
+	}
+	for(int32 FriendId : RosterDelta.AddedFriendIds)
+	{
+		Track(InsertFriend(FriendId));
+	}
+
+	NotifyViewChanged(FirstChangedIndex);
+}
+
+void UOnlineSampleFriendListView::HandleFriendPresenceUpdated(const FBlueprintPresenceInfo& PresenceInfo)
+{
+	// 이름순 뷰는 현재 상태로 순서가 바뀌지 않지만 표시는 바뀔 수 있으니 그 자리만 알립니다.
+	if(SortMode != EFriendListSortMode::OnlineThenName)
+	{
+		NotifyViewChanged(IndexOfFriend(PresenceInfo.AccountHandle));
+		return;
+	}
+	NotifyViewChanged(RefreshFriend(PresenceInfo.AccountHandle));
+}
+
+void UOnlineSampleFriendListView::HandleFriendLastPlayedUpdated(int32 FriendId)
+{
+	if(SortMode == EFriendListSortMode::RecentlyPlayed)
+	{
+		NotifyViewChanged(RefreshFriend(FriendId));
+	}
+}
+
+void UOnlineSampleFriendListView::NotifyViewChanged(int32 FirstChangedIndex)
+{
+	if(FirstChangedIndex == INDEX_NONE)
+	{
+		return;
+	}
+	
+	OnViewChangedEvent.Broadcast(FirstChangedIndex);
+	K2_OnViewChangedEvent.Broadcast(FirstChangedIndex);
+}
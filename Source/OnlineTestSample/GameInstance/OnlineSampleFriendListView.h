@@ -0,0 +1,107 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "OnlineSampleOnlineSubsystem.h"
+#include "OnlineSampleFriendListView.generated.h"
+
+UENUM(BlueprintType)
+enum class EFriendListSortMode : uint8
+{
+	/** 온라인 친구 먼저, 그 안에서는 이름순 */
+	OnlineThenName,
+	/** 이름순 */
+	Name,
+	/** 최근에 같은 로비에 있었던 순. 같이 있었던 적 없는 친구는 뒤에 이름순으로 */
+	RecentlyPlayed
+};
+
+DECLARE_MULTICAST_DELEGATE_OneParam(FFriendListViewChanged, int32 FirstChangedIndex);
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FFriendListViewChanged_Dynamic, int32, FirstChangedIndex);
+
+/**
+ * 친구 목록 저장소 위에 얹는 정렬/필터 뷰입니다.
+ *		계정 핸들을 정렬된 배열로 들고, 친구 목록이나 현재 상태가 바뀌면 그 친구만 이진 탐색으로 빼고 다시 넣습니다.
+ *		가상화 리스트 위젯은 Num과 GetRange로 보이는 구간만 꺼내면 됩니다
+ */
+UCLASS(BlueprintType)
+class ONLINETESTSAMPLE_API UOnlineSampleFriendListView : public UObject
+{
+	GENERATED_BODY()
+
+public:
+
+	/** 뷰를 만들어 서브시스템 이벤트에 붙입니다. 뷰는 서브시스템이 들고 있지 않으므로 쓰는 쪽이 참조를 유지해야 합니다 */
+	UFUNCTION(BlueprintCallable)
+	static UOnlineSampleFriendListView* CreateFriendListView(UOnlineSampleOnlineSubsystem* OnlineSubsystem, EFriendListSortMode InSortMode, const FString& InFilterText);
+	
+	virtual void BeginDestroy() override;
+
+	/** 정렬 기준을 바꾸면 전체를 한 번 다시 정렬합니다 */
+	UFUNCTION(BlueprintCallable)
+	void SetSortMode(EFriendListSortMode InSortMode);
+	/** 표시 이름이나 별명에 포함된 친구만 남깁니다. 대소문자는 보지 않고, 빈 문자열이면 모두 보입니다 */
+	UFUNCTION(BlueprintCallable)
+	void SetFilterText(const FString& InFilterText);
+
+	UFUNCTION(BlueprintPure)
+	EFriendListSortMode GetSortMode() const { return SortMode; }
+	UFUNCTION(BlueprintPure)
+	int32 Num() const { return SortedHandles.Num(); }
+	
+	UFUNCTION(BlueprintCallable)
+	bool GetFriendAt(int32 Index, FBlueprintFriendInfo& OutFriendInfo) const;
+	/** [First, First + Count) 구간만 꺼냅니다. 범위를 넘는 부분은 잘립니다 */
+	UFUNCTION(BlueprintCallable)
+	void GetRange(int32 First, int32 Count, TArray<FBlueprintFriendInfo>& OutFriendInfos) const;
+	/** 뷰 안에서의 위치. 필터에 걸렸거나 없는 친구면 INDEX_NONE */
+	UFUNCTION(BlueprintPure)
+	int32 IndexOfFriend(int32 FriendId) const;
+
+	/** 순서나 내용이 바뀌었을 때 옵니다. 그 앞 구간은 그대로입니다 */
+	FFriendListViewChanged OnViewChangedEvent;
+	UPROPERTY(BlueprintAssignable, meta = (DisplayName = "On View Changed"))
+	FFriendListViewChanged_Dynamic K2_OnViewChangedEvent;
+
+private:
+
+	void Initialize(UOnlineSampleOnlineSubsystem* InSubsystem, EFriendListSortMode InSortMode, const FString& InFilterText);
+
+	/** 정렬에 쓰는 값을 들어올 때 복사해 둡니다. 빠진 친구도 예전 위치를 다시 찾을 수 있습니다 */
+	struct FSortKey
+	{
+		int32 Rank = 0;
+		FDateTime LastPlayedTime;
+		FString Name;
+		int32 Handle = INDEX_NONE;
+	};
+
+	bool IsLess(const FSortKey& A, const FSortKey& B) const;
+	FSortKey MakeSortKey(int32 FriendId) const;
+	bool PassesFilter(int32 Slot) const;
+	int32 LowerBound(const FSortKey& Key) const;
+
+	/** 넣은/뺀 위치를 돌려줍니다. 아무것도 안 했으면 INDEX_NONE */
+	int32 InsertFriend(int32 FriendId);
+	int32 RemoveFriend(int32 FriendId);
+	/** 정렬 값이 바뀌었으면 빼고 다시 넣습니다. 바뀐 구간의 시작을 돌려줍니다 */
+	int32 RefreshFriend(int32 FriendId);
+	void Rebuild();
+
+	void HandleFriendRosterChanged(const FBlueprintFriendRosterDelta& RosterDelta);
+	void HandleFriendPresenceUpdated(const FBlueprintPresenceInfo& PresenceInfo);
+	void HandleFriendLastPlayedUpdated(int32 FriendId);
+	void NotifyViewChanged(int32 FirstChangedIndex);
+
+	TWeakObjectPtr<UOnlineSampleOnlineSubsystem> Subsystem;
+	EFriendListSortMode SortMode = EFriendListSortMode::OnlineThenName;
+	FString FilterText;
+
+	TArray<int32> SortedHandles;
+	TMap<int32, FSortKey> SortKeys;
+
+	FDelegateHandle FriendRosterChangedHandle;
+	FDelegateHandle FriendPresenceUpdatedHandle;
+	FDelegateHandle FriendLastPlayedUpdatedHandle;
+};
@@ -0,0 +1,153 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "OnlineSampleFriendRoster.h"
+
+#include "Online/Social.h"
+
+int32 FOnlineSampleStringPool::Acquire(const FString& Value)
+{
+	if(Value.IsEmpty())
+	{
+		return INDEX_NONE;
+	}
+
+	if(const int32* ExistingId = Ids.Find(Value))
+	{
+		++RefCounts[*ExistingId];
+		return *ExistingId;
+	}
+
+	int32 StringId = INDEX_NONE;
+	if(FreeIds.Num() > 0)
+	{
+		StringId = FreeIds.Pop(EAllowShrinking::No);
+		Strings[StringId] = Value;
+		RefCounts[StringId] = 1;
+	}
+	else
+	{
+		StringId = Strings.Add(Value);
+		RefCounts.Add(1);
+	}
+	
+	Ids.Add(Value, StringId);
+	return StringId;
+}
+
+void FOnlineSampleStringPool::Release(int32 StringId)
+{
+	if(StringId == INDEX_NONE || --RefCounts[StringId] > 0)
+	{
+		return;
+	}
+
+	Ids.Remove(Strings[StringId]);
+	Strings[StringId].Empty();
+	FreeIds.Add(StringId);
+}
+
+void FOnlineSampleFriendRoster::Sync(const TArray<TSharedRef<UE::Online::FFriend>>& Friends, TArray<int32>& OutAdded, TArray<int32>& OutRemoved, TArray<int32>& OutChanged)
+{
+	using namespace UE::Online;
+	
+	++SyncRevision;
+	
+	TSet<int32> ReceivedHandles;
+	ReceivedHandles.Reserve(Friends.Num());
+
+	for(const TSharedRef<FFriend>& Friend : Friends)
+	{
+		const int32 FriendHandle = Friend->FriendId.GetHandle();
+		ReceivedHandles.Add(FriendHandle);
+
+		int32 Slot = FindSlot(FriendHandle);
+		if(Slot == INDEX_NONE)
+		{
+			Slot = AllocateSlot();
+			Handles[Slot] = FriendHandle;
+			AccountIds[Slot] = Friend->FriendId;
+			DisplayNameIds[Slot] = StringPool.Acquire(Friend->DisplayName);
+			NicknameIds[Slot] = StringPool.Acquire(Friend->Nickname);
+			Revisions[Slot] = SyncRevision;
+			SlotByHandle.Add(FriendHandle, Slot);
+			OutAdded.Add(FriendHandle);
+			continue;
+		}
+
+		// 같은 문자열이면 풀을 건드리지 않습니다.
+		const bool bDisplayNameChanged = !GetDisplayName(Slot).Equals(Friend->DisplayName, ESearchCase::CaseSensitive);
+		const bool bNicknameChanged = !GetNickname(Slot).Equals(Friend->Nickname, ESearchCase::CaseSensitive);
+		if(bDisplayNameChanged)
+		{
+			const int32 NewId = StringPool.Acquire(Friend->DisplayName);
+			StringPool.Release(DisplayNameIds[Slot]);
+			DisplayNameIds[Slot] = NewId;
+		}
+		if(bNicknameChanged)
+		{
+			const int32 NewId = StringPool.Acquire(Friend->Nickname);
+			StringPool.Release(NicknameIds[Slot]);
+			NicknameIds[Slot] = NewId;
+		}
+		if(bDisplayNameChanged || bNicknameChanged)
+		{
+			Revisions[Slot] = SyncRevision;
+			OutChanged.Add(FriendHandle);
+		}
+	}
+
+	for(int32 Slot = 0; Slot < Handles.Num(); ++Slot)
+	{
+		if(Handles[Slot] != INDEX_NONE && !ReceivedHandles.Contains(Handles[Slot]))
+		{
+			OutRemoved.Add(Handles[Slot]);
+			FreeSlot(Slot);
+		}
+	}
+}
+
+void FOnlineSampleFriendRoster::Reset()
+{
+	*this = FOnlineSampleFriendRoster();
+}
+
+void FOnlineSampleFriendRoster::GetAccountIds(TArray<UE::Online::FAccountId>& OutAccountIds) const
+{
+	OutAccountIds.Reset(Num());
+	for(int32 Slot = 0; Slot < Handles.Num(); ++Slot)
+	{
+		if(Handles[Slot] != INDEX_NONE)
+		{
+			OutAccountIds.Add(AccountIds[Slot]);
+		}
+	}
+}
+
+int32 FOnlineSampleFriendRoster::AllocateSlot()
+{
+	if(FreeSlots.Num() > 0)
+	{
+		return FreeSlots.Pop(EAllowShrinking::No);
+	}
+
+	Handles.Add(INDEX_NONE);
+	AccountIds.AddDefaulted();
+	DisplayNameIds.Add(INDEX_NONE);
+	NicknameIds.Add(INDEX_NONE);
+	return Revisions.Add(0);
+}
+
+void FOnlineSampleFriendRoster::FreeSlot(int32 Slot)
+{
+	SlotByHandle.Remove(Handles[Slot]);
+	StringPool.Release(DisplayNameIds[Slot]);
+	StringPool.Release(NicknameIds[Slot]);
+	
+	Handles[Slot] = INDEX_NONE;
+	AccountIds[Slot] = UE::Online::FAccountId();
+	DisplayNameIds[Slot] = INDEX_NONE;
+	NicknameIds[Slot] = INDEX_NONE;
+	Revisions[Slot] = SyncRevision;
+	FreeSlots.Add(Slot);
+}
@@ -0,0 +1,102 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Online/CoreOnline.h"
+
+namespace UE::Online
+{
+	struct FFriend;
+}
+
+/**
+ * 대소문자를 구분하는 문자열 풀입니다.
+ *		같은 이름은 한 번만 저장하고 정수 ID로 나눠 씁니다. 참조 수가 0이 되면 자리를 비워 다시 씁니다
+ */
+class ONLINETESTSAMPLE_API FOnlineSampleStringPool
+{
+public:
+
+	/** 문자열을 넣고 참조 수를 하나 올립니다. 빈 문자열은 항상 INDEX_NONE */
+	int32 Acquire(const FString& Value);
+	/** 참조 수를 하나 내립니다 */
+	void Release(int32 StringId);
+
+	const FString& Get(int32 StringId) const
+	{
+		return StringId == INDEX_NONE ? EmptyString : Strings[StringId];
+	}
+
+	int32 Num() const { return Ids.Num(); }
+
+private:
+
+	struct FCaseSensitiveKeyFuncs : TDefaultMapHashableKeyFuncs<FString, int32, false>
+	{
+		static bool Matches(const FString& A, const FString& B) { return A.Equals(B, ESearchCase::CaseSensitive); }
+		static uint32 GetKeyHash(const FString& Key) { return FCrc::StrCrc32(*Key); }
+	};
+
+	TArray<FString> Strings;
+	TArray<int32> RefCounts;
+	TArray<int32> FreeIds;
+	TMap<FString, int32, FDefaultSetAllocator, FCaseSensitiveKeyFuncs> Ids;
+	FString EmptyString;
+};
+
+/**
+ * 친구 목록 저장소입니다. FFriend를 가리키지 않고 필요한 값만 복사해서 소유합니다.
+ *		필드별 배열(SoA)에 두고 슬롯 번호로 접근합니다. 슬롯은 친구가 빠져도 다른 친구의 번호가 바뀌지 않도록
+ *		비워두었다가 다음에 들어오는 친구가 다시 씁니다. 정렬/필터 뷰는 이 슬롯 번호를 들고 있으면 됩니다
+ */
+class ONLINETESTSAMPLE_API FOnlineSampleFriendRoster
+{
+public:
+
+	/**
+	 * 새 친구 목록과 비교해서 바뀐 슬롯만 고칩니다.
+	 *		결과는 계정 핸들(FriendId)입니다. 빠진 친구는 슬롯을 비우기 전에 OutRemoved에 담깁니다
+	 */
+	void Sync(const TArray<TSharedRef<UE::Online::FFriend>>& Friends, TArray<int32>& OutAdded, TArray<int32>& OutRemoved, TArray<int32>& OutChanged);
+	void Reset();
+
+	/** 살아 있는 친구 수 */
+	int32 Num() const { return SlotByHandle.Num(); }
+	/** 슬롯 배열 길이. 빈 슬롯도 포함합니다 */
+	int32 GetSlotCapacity() const { return Handles.Num(); }
+	bool IsValidSlot(int32 Slot) const { return Handles.IsValidIndex(Slot) && Handles[Slot] != INDEX_NONE; }
+	
+	int32 FindSlot(int32 FriendHandle) const
+	{
+		const int32* Slot = SlotByHandle.Find(FriendHandle);
+		return Slot ? *Slot : INDEX_NONE;
+	}
+
+	int32 GetHandle(int32 Slot) const { return Handles[Slot]; }
+	const UE::Online::FAccountId& GetAccountId(int32 Slot) const { return AccountIds[Slot]; }
+	const FString& GetDisplayName(int32 Slot) const { return StringPool.Get(DisplayNameIds[Slot]); }
+	const FString& GetNickname(int32 Slot) const { return StringPool.Get(NicknameIds[Slot]); }
+	/** 슬롯이 마지막으로 바뀐 Sync 번호. 뷰가 다시 정렬할지 판단할 때 씁니다 */
+	uint32 GetSlotRevision(int32 Slot) const { return Revisions[Slot]; }
+
+	/** 살아 있는 친구의 계정 ID를 슬롯 순서대로 모읍니다 */
+	void GetAccountIds(TArray<UE::Online::FAccountId>& OutAccountIds) const;
+
+private:
+
+	int32 AllocateSlot();
+	void FreeSlot(int32 Slot);
+
+	/** 빈 슬롯은 INDEX_NONE */
+	TArray<int32> Handles;
+	TArray<UE::Online::FAccountId> AccountIds;
+	TArray<int32> DisplayNameIds;
+	TArray<int32> NicknameIds;
+	TArray<uint32> Revisions;
+	
+	TArray<int32> FreeSlots;
+	TMap<int32, int32> SlotByHandle;
+	FOnlineSampleStringPool StringPool;
+	uint32 SyncRevision = 0;
+};
@@ -0,0 +1,302 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "OnlineSampleLanBeacon.h"
+
+#include "Common/UdpSocketBuilder.h"
+#include "Interfaces/IPv4/IPv4Endpoint.h"
+#include "Misc/NetworkVersion.h"
+#include "Serialization/BufferArchive.h"
+#include "Serialization/MemoryReader.h"
+#include "Sockets.h"
+#include "SocketSubsystem.h"
+
+namespace OnlineSampleLanBeacon
+{
+	/** 인터넷 너머로는 나가지 않는 주소인지 봅니다. 위조한 출발지로 외부에 응답을 떠넘길 수 없게 합니다 */
+	static bool IsLocalNetworkAddress(const FIPv4Address& Address)
+	{
+		return Address.IsLoopbackAddress() || Address.IsSiteLocalAddress() || Address.IsLinkLocalAddress();
+	}
+
+	static void DestroySocket(FSocket*& Socket)
+	{
+		if(Socket)
+		{
+			Socket->Close();
+			ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM)->DestroySocket(Socket);
+			Socket = nullptr;
+		}
+	}
+}
+
+FArchive& operator<<(FArchive& Ar, FOnlineSampleLanHostInfo& HostInfo)
+{
+	Ar << HostInfo.InstanceId << HostInfo.HostName << HostInfo.GamePort << HostInfo.MaxPlayers << HostInfo.NumPlayers;
+
+	// TMap의 기본 직렬화는 패킷에 적힌 개수만큼 먼저 할당하므로 개수를 직접 확인하며 읽습니다.
+	int32 NumAttributes = FMath::Min(HostInfo.Attributes.Num(), OnlineSampleLanBeacon::MaxAttributes);
+	Ar << NumAttributes;
+	if(Ar.IsLoading())
+	{
+		HostInfo.Attributes.Reset();
+		if(NumAttributes < 0 || NumAttributes > OnlineSampleLanBeacon::MaxAttributes)
+		{
+			Ar.SetError();
+			return Ar;
+		}
+		for(int32 Index = 0; Index < NumAttributes && !Ar.IsError(); ++Index)
+		{
+			FString Key;
+			FString Value;
+			Ar << Key << Value;
+			HostInfo.Attributes.Add(MoveTemp(Key), MoveTemp(Value));
+		}
+	}
+	else
+	{
+		int32 NumWritten = 0;
+		for(TPair<FString, FString>& Attribute : HostInfo.Attributes)
+		{
+			if(NumWritten++ >= NumAttributes)
+			{
+				break;
+			}
+			Ar << const_cast<FString&>(Attribute.Key) << Attribute.Value;
+		}
+	}
+	return Ar;
+}
+
+FOnlineSampleLanBeaconHost::~FOnlineSampleLanBeaconHost()
+{
+	Stop();
+}
+
+bool FOnlineSampleLanBeaconHost::Start(int32 Port, FOnQuery&& InOnQuery)
+{
+	Stop();
+
+	// 같은 머신에서 호스트 여럿을 띄울 수 있도록 재사용 소켓으로 엽니다.
+	Socket = FUdpSocketBuilder(TEXT("OnlineSampleLanBeaconHost"))
+		.AsNonBlocking()
+		.AsReusable()
+		.WithBroadcast()
+		.BoundToEndpoint(FIPv4Endpoint(FIPv4Address::Any, Port))
+		.Build();
+	if(!Socket)
+	{
+		return false;
+	}
+
+	OnQuery = MoveTemp(InOnQuery);
+	InstanceId = FGuid::NewGuid();
+	return true;
+}
+
+void FOnlineSampleLanBeaconHost::Stop()
+{
+	OnQuery = nullptr;
+	LastReplyTimes.Reset();
+	OnlineSampleLanBeacon::DestroySocket(Socket);
+}
+
+bool FOnlineSampleLanBeaconHost::Tick(float DeltaTime)
+{
+	if(!Socket || !OnQuery)
+	{
+		return true;
+	}
+
+	const double Now = FPlatformTime::Seconds();
+	for(auto It = LastReplyTimes.CreateIterator(); It; ++It)
+	{
+		if(Now - It.Value() >= OnlineSampleLanBeacon::MinReplyIntervalSeconds)
+		{
+			It.RemoveCurrent();
+		}
+	}
+
+	TSharedRef<FInternetAddr> Sender = ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM)->CreateInternetAddr();
+	uint8 Packet[OnlineSampleLanBeacon::MaxPacketSize];
+	int32 BytesRead = 0;
+
+	while(Socket && Socket->RecvFrom(Packet, sizeof(Packet), BytesRead, *Sender))
+	{
+		if(BytesRead != OnlineSampleLanBeacon::QuerySize)
+		{
+			continue;
+		}
+
+		const FIPv4Address SenderAddress = FIPv4Endpoint(Sender).Address;
+		if(!OnlineSampleLanBeacon::IsLocalNetworkAddress(SenderAddress) || LastReplyTimes.Contains(SenderAddress))
+		{
+			continue;
+		}
+
+		uint32 Magic = 0;
+		uint32 NetworkVersion = 0;
+		uint32 Nonce = 0;
+		FMemory::Memcpy(&Magic, Packet, 4);
+		FMemory::Memcpy(&NetworkVersion, Packet + 4, 4);
+		FMemory::Memcpy(&Nonce, Packet + 8, 4);
+		if(Magic != OnlineSampleLanBeacon::QueryMagic || NetworkVersion != FNetworkVersion::GetLocalNetworkVersion())
+		{
+			continue;
+		}
+
+		FOnlineSampleLanHostInfo HostInfo;
+		if(!OnQuery(HostInfo))
+		{
+			continue;
+		}
+		HostInfo.InstanceId = InstanceId;
+		FBufferArchive Response;
+		uint32 ResponseMagic = OnlineSampleLanBeacon::ResponseMagic;
+		Response << ResponseMagic << Nonce << HostInfo;
+		if(Response.Num() > OnlineSampleLanBeacon::MaxPacketSize)
+		{
+			// 속성이 너무 많으면 속성만 빼고 보냅니다.
+			HostInfo.Attributes.Reset();
+			Response.Reset();
+			Response << ResponseMagic << Nonce << HostInfo;
+		}
+		// 응답이 질의보다 커지면 보내지 않습니다.
+		if(Response.Num() > OnlineSampleLanBeacon::QuerySize)
+		{
+			continue;
+		}
+
+		int32 BytesSent = 0;
+		Socket->SendTo(Response.GetData(), Response.Num(), BytesSent, *Sender);
+		LastReplyTimes.Add(SenderAddress, Now);
+	}
+	return true;
+}
+
+FOnlineSampleLanBeaconClient::~FOnlineSampleLanBeaconClient()
+{
+	OnResponse = nullptr;
+	OnComplete = nullptr;
+	OnlineSampleLanBeacon::DestroySocket(Socket);
+}
+
+bool FOnlineSampleLanBeaconClient::Start(int32 Port, float TimeoutSeconds, bool bIncludeLoopback, FOnResponse&& InOnResponse, FOnComplete&& InOnComplete)
+{
+	Cancel();
+
+	Socket = FUdpSocketBuilder(TEXT("OnlineSampleLanBeaconClient"))
+		.AsNonBlocking()
+		.WithBroadcast()
+		.BoundToPort(0)
+		.Build();
+	if(!Socket)
+	{
+		return false;
+	}
+
+	OnResponse = MoveTemp(InOnResponse);
+	OnComplete = MoveTemp(InOnComplete);
+	RespondedHosts.Reset();
+	Nonce = FMath::Rand();
+	DeadlineTime = FPlatformTime::Seconds() + TimeoutSeconds;
+
+	uint8 Packet[OnlineSampleLanBeacon::QuerySize] = {};
+	const uint32 Magic = OnlineSampleLanBeacon::QueryMagic;
+	const uint32 NetworkVersion = FNetworkVersion::GetLocalNetworkVersion();
+	FMemory::Memcpy(Packet, &Magic, 4);
+	FMemory::Memcpy(Packet + 4, &NetworkVersion, 4);
+	FMemory::Memcpy(Packet + 8, &Nonce, 4);
+
+	// 루프백으로도 보내서 브로드캐스트가 막힌 환경에서도 같은 머신의 호스트는 찾습니다.
+	TArray<FIPv4Endpoint, TInlineAllocator<2>> Targets;
+	Targets.Add(FIPv4Endpoint(FIPv4Address::LanBroadcast, Port));
+	if(bIncludeLoopback)
+	{
+		Targets.Add(FIPv4Endpoint(FIPv4Address::InternalLoopback, Port));
+	}
+
+	int32 NumSent = 0;
+	for(const FIPv4Endpoint& Target : Targets)
+	{
+		int32 BytesSent = 0;
+		if(Socket->SendTo(Packet, sizeof(Packet), BytesSent, *Target.ToInternetAddr()))
+		{
+			++NumSent;
+		}
+	}
+
+	// 질의를 하나도 못 보냈으면 완료 콜백 없이 실패를 돌려줍니다.
+	if(NumSent == 0)
+	{
+		Cancel();
+		return false;
+	}
+	return true;
+}
+
+void FOnlineSampleLanBeaconClient::Cancel()
+{
+	OnResponse = nullptr;
+	OnComplete = nullptr;
+	OnlineSampleLanBeacon::DestroySocket(Socket);
+}
+
+bool FOnlineSampleLanBeaconClient::Tick(float DeltaTime)
+{
+	if(!Socket)
+	{
+		return true;
+	}
+
+	TSharedRef<FInternetAddr> Sender = ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM)->CreateInternetAddr();
+	uint8 Packet[OnlineSampleLanBeacon::MaxPacketSize];
+	int32 BytesRead = 0;
+
+	while(Socket && Socket->RecvFrom(Packet, sizeof(Packet), BytesRead, *Sender))
+	{
+		// 문자열 길이 접두어가 패킷보다 크면 할당 전에 오류로 끝나게 합니다.
+		FMemoryReaderView Reader(MakeArrayView(Packet, BytesRead));
+		Reader.ArMaxSerializeSize = OnlineSampleLanBeacon::MaxPacketSize;
+		
+		uint32 Magic = 0;
+		uint32 ResponseNonce = 0;
+		FOnlineSampleLanHostInfo HostInfo;
+		Reader << Magic << ResponseNonce;
+		if(Reader.IsError() || Magic != OnlineSampleLanBeacon::ResponseMagic || ResponseNonce != Nonce)
+		{
+			continue;
+		}
+		Reader << HostInfo;
+		if(Reader.IsError() || Reader.Tell() != BytesRead)
+		{
+			continue;
+		}
+
+		bool bAlreadyResponded = false;
+		RespondedHosts.Add(HostInfo.InstanceId, &bAlreadyResponded);
+		if(!bAlreadyResponded && OnResponse)
+		{
+			OnResponse(FString::Printf(TEXT("%s:%d"), *Sender->ToString(false), HostInfo.GamePort), HostInfo);
+		}
+	}
+
+	if(Socket && FPlatformTime::Seconds() >= DeadlineTime)
+	{
+		Finish();
+	}
+	return true;
+}
+
+void FOnlineSampleLanBeaconClient::Finish()
+{
+	OnlineSampleLanBeacon::DestroySocket(Socket);
+	OnResponse = nullptr;
+
+	if(OnComplete)
+	{
+		FOnComplete Callback = MoveTemp(OnComplete);
+		OnComplete = nullptr;
+		Callback();
+	}
+}
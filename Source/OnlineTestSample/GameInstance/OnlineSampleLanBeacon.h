@@ -0,0 +1,111 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Containers/Ticker.h"
+#include "Interfaces/IPv4/IPv4Address.h"
+
+class FSocket;
+
+/**
+ * LAN 세션을 찾는 UDP 브로드캐스트 비컨 프로토콜입니다.
+ *		질의는 매직(4) + 네트워크 버전(4) + 논스(4) 뒤를 0으로 채운 MaxPacketSize 바이트, 응답은 매직(4) + 논스(4) 뒤에 FOnlineSampleLanHostInfo를 직렬화해 붙입니다.
+ *		질의를 응답 최대 크기까지 채워 두어 응답이 질의보다 커지지 않으므로 UDP 반사 증폭에 쓰일 수 없습니다.
+ *		네트워크 버전이 다른 클라이언트의 질의에는 응답하지 않습니다
+ */
+namespace OnlineSampleLanBeacon
+{
+	constexpr uint32 QueryMagic = 0x51424C4F; // 'OLBQ'
+	constexpr uint32 ResponseMagic = 0x52424C4F; // 'OLBR'
+	constexpr int32 MaxPacketSize = 1024;
+	constexpr int32 QuerySize = MaxPacketSize;
+	/** 같은 주소에 응답을 다시 보내기까지 기다리는 시간 */
+	constexpr double MinReplyIntervalSeconds = 0.25;
+	/** 응답 하나에 싣는 속성 수의 상한. 받는 쪽은 이보다 많다고 적힌 패킷을 버립니다 */
+	constexpr int32 MaxAttributes = 32;
+}
+
+/** 호스트가 비컨 응답에 싣는 값입니다 */
+struct FOnlineSampleLanHostInfo
+{
+	/** 호스트를 켤 때마다 새로 만듭니다. 주소가 여럿인 호스트를 한 번만 세는 데 씁니다 */
+	FGuid InstanceId;
+	FString HostName;
+	/** 게임 접속 포트. 응답을 보낸 주소와 합쳐 접속 주소가 됩니다 */
+	int32 GamePort = 0;
+	int32 MaxPlayers = 0;
+	int32 NumPlayers = 0;
+	TMap<FString, FString> Attributes;
+
+	/**
+	 * 응답은 인증되지 않은 UDP 패킷이므로, 읽을 때 속성 개수를 MaxAttributes로 제한하고 넘으면 Ar에 오류를 남깁니다.
+	 *		문자열 길이는 읽는 쪽 아카이브의 ArMaxSerializeSize로 제한합니다
+	 */
+	friend ONLINETESTSAMPLE_API FArchive& operator<<(FArchive& Ar, FOnlineSampleLanHostInfo& HostInfo);
+};
+
+/**
+ * 호스트에서 도는 비컨 응답자입니다. 코어 티커에서 논블로킹 소켓을 비우고,
+ *		질의가 올 때마다 콜백으로 최신 호스트 정보를 받아 보낸 쪽에 직접 답합니다.
+ *		루프백, 사설, 링크 로컬 주소에서 온 질의에만, 주소마다 MinReplyIntervalSeconds에 한 번까지만 답합니다
+ */
+class ONLINETESTSAMPLE_API FOnlineSampleLanBeaconHost : public FTSTickerObjectBase
+{
+public:
+
+	/** false를 돌려주면 이번 질의에는 답하지 않습니다 */
+	using FOnQuery = TFunction<bool(FOnlineSampleLanHostInfo& OutHostInfo)>;
+
+	virtual ~FOnlineSampleLanBeaconHost() override;
+
+	bool Start(int32 Port, FOnQuery&& InOnQuery);
+	void Stop();
+
+	bool IsRunning() const { return Socket != nullptr; }
+
+	virtual bool Tick(float DeltaTime) override;
+
+private:
+
+	FSocket* Socket = nullptr;
+	FOnQuery OnQuery;
+	FGuid InstanceId;
+	/** 주소별 마지막 응답 시각 */
+	TMap<FIPv4Address, double> LastReplyTimes;
+};
+
+/**
+ * 비컨 질의를 브로드캐스트(와 루프백)로 보내고 응답을 모읍니다.
+ *		응답은 오는 대로 넘기고, 시간이 다 되면 완료 콜백을 한 번 부릅니다
+ */
+class ONLINETESTSAMPLE_API FOnlineSampleLanBeaconClient : public FTSTickerObjectBase
+{
+public:
+
+	/** HostAddress는 "IP:GamePort"입니다 */
+	using FOnResponse = TFunction<void(const FString& HostAddress, const FOnlineSampleLanHostInfo& HostInfo)>;
+	using FOnComplete = TFunction<void()>;
+
+	virtual ~FOnlineSampleLanBeaconClient() override;
+
+	/** 소켓을 열지 못했거나 질의를 하나도 보내지 못하면 false이고, 이때 InOnComplete는 불리지 않습니다 */
+	bool Start(int32 Port, float TimeoutSeconds, bool bIncludeLoopback, FOnResponse&& InOnResponse, FOnComplete&& InOnComplete);
+	void Cancel();
+
+	bool IsRunning() const { return Socket != nullptr; }
+
+	virtual bool Tick(float DeltaTime) override;
+
+private:
+
+	void Finish();
+
+	FSocket* Socket = nullptr;
+	/** 같은 호스트가 브로드캐스트와 루프백 양쪽으로 답해도 한 번만 넘깁니다 */
+	TSet<FGuid> RespondedHosts;
+	uint32 Nonce = 0;
+	double DeadlineTime = 0.0;
+	FOnResponse OnResponse;
+	FOnComplete OnComplete;
+};
@@ -0,0 +1,233 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "OnlineSampleLobbyQuery.h"
+
+#include "Misc/ConfigCacheIni.h"
+
+UE::Online::FSchemaVariant FBlueprintLobbySearchFilter::ToSchemaVariant() const
+{
+	using namespace UE::Online;
+	
+	switch(ValueType)
+	{
+	case ELobbySearchValueType::Bool:
+		return FSchemaVariant(bBoolValue);
+	case ELobbySearchValueType::Int64:
+		return FSchemaVariant(IntValue);
+	case ELobbySearchValueType::Double:
+		return FSchemaVariant(DoubleValue);
+	default:
+		return FSchemaVariant(StringValue);
+	}
+}
+
+UE::Online::ESchemaAttributeComparisonOp FBlueprintLobbySearchFilter::ToComparisonOp() const
+{
+	using namespace UE::Online;
+	
+	switch(Comparison)
+	{
+	case ELobbySearchComparison::NotEquals:
+		return ESchemaAttributeComparisonOp::NotEquals;
+	case ELobbySearchComparison::GreaterThan:
+		return ESchemaAttributeComparisonOp::GreaterThan;
+	case ELobbySearchComparison::GreaterThanEquals:
+		return ESchemaAttributeComparisonOp::GreaterThanEquals;
+	case ELobbySearchComparison::LessThan:
+		return ESchemaAttributeComparisonOp::LessThan;
+	case ELobbySearchComparison::LessThanEquals:
+		return ESchemaAttributeComparisonOp::LessThanEquals;
+	default:
+		return ESchemaAttributeComparisonOp::Equals;
+	}
+}
+
+FBlueprintLobbySearchQuery& FBlueprintLobbySearchQuery::Where(FName AttributeName, ELobbySearchComparison Comparison, const FString& Value)
+{
+	FBlueprintLobbySearchFilter& Filter = Filters.AddDefaulted_GetRef();
+	Filter.AttributeName = AttributeName;
+	Filter.Comparison = Comparison;
+	Filter.ValueType = ELobbySearchValueType::String;
+	Filter.StringValue = Value;
+	return *this;
+}
+
+FBlueprintLobbySearchQuery& FBlueprintLobbySearchQuery::Where(FName AttributeName, ELobbySearchComparison Comparison, const TCHAR* Value)
+{
+	// 문자열 리터럴이 bool 오버로드로 가지 않도록 따로 받습니다.
+	return Where(AttributeName, Comparison, FString(Value));
+}
+
+FBlueprintLobbySearchQuery& FBlueprintLobbySearchQuery::Where(FName AttributeName, ELobbySearchComparison Comparison, int64 Value)
+{
+	FBlueprintLobbySearchFilter& Filter = Filters.AddDefaulted_GetRef();
+	Filter.AttributeName = AttributeName;
+	Filter.Comparison = Comparison;
+	Filter.ValueType = ELobbySearchValueType::Int64;
+	Filter.IntValue = Value;
+	return *this;
+}
+
+FBlueprintLobbySearchQuery& FBlueprintLobbySearchQuery::Where(FName AttributeName, ELobbySearchComparison Comparison, double Value)
+{
+	FBlueprintLobbySearchFilter& Filter = Filters.AddDefaulted_GetRef();
+	Filter.AttributeName = AttributeName;
+	Filter.Comparison = Comparison;
+	Filter.ValueType = ELobbySearchValueType::Double;
+	Filter.DoubleValue = Value;
+	return *this;
+}
+
+FBlueprintLobbySearchQuery& FBlueprintLobbySearchQuery::Where(FName AttributeName, ELobbySearchComparison Comparison, bool Value)
+{
+	FBlueprintLobbySearchFilter& Filter = Filters.AddDefaulted_GetRef();
+	Filter.AttributeName = AttributeName;
+	Filter.Comparison = Comparison;
+	Filter.ValueType = ELobbySearchValueType::Bool;
+	Filter.bBoolValue = Value;
+	return *this;
+}
+
+/// <summary>
+/// 스키마에 없는 속성, Searchable이 아닌 속성, 타입이 다르거나 MaxSize를 넘는 값,
+///		문자열/불리언에 대한 대소 비교를 걸러냅니다
+/// </summary>
+/// <param name="OutErrors">검사에 실패한 필터마다 한 줄씩 담깁니다</param>
+/// <returns>모든 필터가 유효하면 true</returns>
+bool FBlueprintLobbySearchQuery::Validate(TArray<FString>& OutErrors) const
+{
+	const FOnlineSampleLobbySchema& Schema = FOnlineSampleLobbySchema::Get();
+	const int32 NumErrorsBefore = OutErrors.Num();
+	
+	for(const FBlueprintLobbySearchFilter& Filter : Filters)
+	{
+		const FOnlineSampleLobbySchema::FAttributeDescriptor* Descriptor = Schema.FindAttribute(Filter.AttributeName);
+		if(!Descriptor)
+		{
+			OutErrors.Add(FString::Printf(TEXT("%s : not in lobby schema"), *Filter.AttributeName.ToString()));
+			continue;
+		}
+		if(!Descriptor->bSearchable)
+		{
+			OutErrors.Add(FString::Printf(TEXT("%s : not Searchable"), *Filter.AttributeName.ToString()));
+		}
+		if(Descriptor->Type != Filter.ValueType)
+		{
+			OutErrors.Add(FString::Printf(TEXT("%s : expected %s, got %s"), *Filter.AttributeName.ToString(),
+				*UEnum::GetValueAsString(Descriptor->Type), *UEnum::GetValueAsString(Filter.ValueType)));
+		}
+		if(Filter.ValueType == ELobbySearchValueType::String && Descriptor->MaxSize > 0 && Filter.StringValue.Len() > Descriptor->MaxSize)
+		{
+			OutErrors.Add(FString::Printf(TEXT("%s : value longer than MaxSize %d"), *Filter.AttributeName.ToString(), Descriptor->MaxSize));
+		}
+		
+		const bool bIsEqualityOnly = Filter.ValueType == ELobbySearchValueType::String || Filter.ValueType == ELobbySearchValueType::Bool;
+		if(bIsEqualityOnly && Filter.Comparison != ELobbySearchComparison::Equals && Filter.Comparison != ELobbySearchComparison::NotEquals)
+		{
+			OutErrors.Add(FString::Printf(TEXT("%s : only Equals/NotEquals allowed for this type"), *Filter.AttributeName.ToString()));
+		}
+	}
+
+	return OutErrors.Num() == NumErrorsBefore;
+}
+
+void FBlueprintLobbySearchQuery::CompileTo(UE::Online::FFindLobbies::Params& FindLobbyParams) const
+{
+	using namespace UE::Online;
+
+	FindLobbyParams.Filters.Reserve(FindLobbyParams.Filters.Num() + Filters.Num());
+	for(const FBlueprintLobbySearchFilter& Filter : Filters)
+	{
+		FindLobbyParams.Filters.Emplace(FFindLobbySearchFilter{ Filter.AttributeName, Filter.ToComparisonOp(), Filter.ToSchemaVariant() });
+	}
+}
+
+const FOnlineSampleLobbySchema& FOnlineSampleLobbySchema::Get()
+{
+	static const FOnlineSampleLobbySchema Schema;
+	return Schema;
+}
+
+/// <summary>
+/// [OnlineServices.Lobbies] 섹션의 SchemaAttributeDescriptors 줄을 읽습니다.
+///		(Id="GAMEMODE", Type="String", Flags=("Public", "Searchable"), MaxSize=64) 형태입니다
+/// </summary>
+FOnlineSampleLobbySchema::FOnlineSampleLobbySchema()
+{
+	TArray<FString> DescriptorLines;
+	GConfig->GetArray(TEXT("OnlineServices.Lobbies"), TEXT("SchemaAttributeDescriptors"), DescriptorLines, GEngineIni);
+
+	for(const FString& Line : DescriptorLines)
+	{
+		FString Id;
+		FString Type;
+		if(!FParse::Value(*Line, TEXT("Id="), Id) || !FParse::Value(*Line, TEXT("Type="), Type))
+		{
+			continue;
+		}
+
+		FAttributeDescriptor Descriptor;
+		if(Type.Equals(TEXT("Bool")))
+		{
+			Descriptor.Type = ELobbySearchValueType::Bool;
+		}
+		else if(Type.Equals(TEXT("Int64")))
+		{
+			Descriptor.Type = ELobbySearchValueType::Int64;
+		}
+		else if(Type.Equals(TEXT("Double")))
+		{
+			Descriptor.Type = ELobbySearchValueType::Double;
+		}
+		
+		Descriptor.bSearchable = Line.Contains(TEXT("\"Searchable\""));
+		FParse::Value(*Line, TEXT("MaxSize="), Descriptor.MaxSize);
+		
+		Attributes.Add(FName(*Id), Descriptor);
+	}
+}
+
+FString FOnlineSampleLobbySchema::VariantToString(const UE::Online::FSchemaVariant& Value)
+{
+	using namespace UE::Online;
+	
+	switch(Value.GetType())
+	{
+	case ESchemaAttributeType::Bool:
+		return Value.GetBoolean() ? TEXT("true") : TEXT("false");
+	case ESchemaAttributeType::Int64:
+		return LexToString(Value.GetInt64());
+	case ESchemaAttributeType::Double:
+		return LexToString(Value.GetDouble());
+	case ESchemaAttributeType::String:
+		return Value.GetString();
+	default:
+		return FString();
+	}
+}
+
+FBlueprintLobbySearchQuery UOnlineSampleLobbyQueryLibrary::AddStringFilter(FBlueprintLobbySearchQuery& Query, FName AttributeName, ELobbySearchComparison Comparison, const FString& Value)
+{
+	return Query.Where(AttributeName, Comparison, Value);
+}
+
+FBlueprintLobbySearchQuery UOnlineSampleLobbyQueryLibrary::AddIntFilter(FBlueprintLobbySearchQuery& Query, FName AttributeName, ELobbySearchComparison Comparison, int64 Value)
+{
+	return Query.Where(AttributeName, Comparison, Value);
+}
+
+FBlueprintLobbySearchQuery UOnlineSampleLobbyQueryLibrary::AddDoubleFilter(FBlueprintLobbySearchQuery& Query, FName AttributeName, ELobbySearchComparison Comparison, double Value)
+{
+	return Query.Where(AttributeName, Comparison, Value);
+}
+
+FBlueprintLobbySearchQuery UOnlineSampleLobbyQueryLibrary::AddBoolFilter(FBlueprintLobbySearchQuery& Query, FName AttributeName, ELobbySearchComparison Comparison, bool Value)
+{
+	return Query.Where(AttributeName, Comparison, Value);
+}
+
+bool UOnlineSampleLobbyQueryLibrary::ValidateLobbySearchQuery(const FBlueprintLobbySearchQuery& Query, TArray<FString>& OutErrors)
+{
+	return Query.Validate(OutErrors);
+}
@@ -0,0 +1,138 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Kismet/BlueprintFunctionLibrary.h"
+#include "Online/Lobbies.h"
+#include "OnlineSampleLobbyQuery.generated.h"
+
+UENUM(BlueprintType)
+enum class ELobbySearchComparison : uint8
+{
+	Equals,
+	NotEquals,
+	GreaterThan,
+	GreaterThanEquals,
+	LessThan,
+	LessThanEquals
+};
+
+UENUM(BlueprintType)
+enum class ELobbySearchValueType : uint8
+{
+	Bool,
+	Int64,
+	Double,
+	String
+};
+
+/** 로비 검색 필터 하나. FFindLobbySearchFilter로 변환됩니다 */
+USTRUCT(BlueprintType)
+struct FBlueprintLobbySearchFilter
+{
+	GENERATED_BODY()
+
+	UPROPERTY(BlueprintReadWrite)
+	FName AttributeName;
+
+	UPROPERTY(BlueprintReadWrite)
+	ELobbySearchComparison Comparison = ELobbySearchComparison::Equals;
+
+	UPROPERTY(BlueprintReadWrite)
+	ELobbySearchValueType ValueType = ELobbySearchValueType::String;
+
+	UPROPERTY(BlueprintReadWrite)
+	FString StringValue;
+
+	UPROPERTY(BlueprintReadWrite)
+	int64 IntValue = 0;
+
+	UPROPERTY(BlueprintReadWrite)
+	double DoubleValue = 0.0;
+
+	UPROPERTY(BlueprintReadWrite)
+	bool bBoolValue = false;
+
+	UE::Online::FSchemaVariant ToSchemaVariant() const;
+	UE::Online::ESchemaAttributeComparisonOp ToComparisonOp() const;
+};
+
+/**
+ * 서버 쪽에서 걸러낼 로비 검색 조건입니다.
+ *		C++에서는 Where를 이어 붙이고, 블루프린트에서는 UOnlineSampleLobbyQueryLibrary를 사용합니다
+ */
+USTRUCT(BlueprintType)
+struct FBlueprintLobbySearchQuery
+{
+	GENERATED_BODY()
+
+	UPROPERTY(BlueprintReadWrite)
+	TArray<FBlueprintLobbySearchFilter> Filters;
+
+	FBlueprintLobbySearchQuery& Where(FName AttributeName, ELobbySearchComparison Comparison, const FString& Value);
+	FBlueprintLobbySearchQuery& Where(FName AttributeName, ELobbySearchComparison Comparison, const TCHAR* Value);
+	FBlueprintLobbySearchQuery& Where(FName AttributeName, ELobbySearchComparison Comparison, int64 Value);
+	FBlueprintLobbySearchQuery& Where(FName AttributeName, ELobbySearchComparison Comparison, double Value);
+	FBlueprintLobbySearchQuery& Where(FName AttributeName, ELobbySearchComparison Comparison, bool Value);
+
+	/** [OnlineServices.Lobbies] 스키마 기준으로 검사합니다. 실패한 이유는 OutErrors에 담깁니다 */
+	bool Validate(TArray<FString>& OutErrors) const;
+
+	/** 검색 파라미터에 필터를 추가합니다. Validate를 먼저 통과해야 합니다 */
+	void CompileTo(UE::Online::FFindLobbies::Params& FindLobbyParams) const;
+};
+
+/**
+ * DefaultEngine.ini의 [OnlineServices.Lobbies] SchemaAttributeDescriptors를 읽어둔 캐시입니다
+ */
+class ONLINETESTSAMPLE_API FOnlineSampleLobbySchema
+{
+public:
+
+	struct FAttributeDescriptor
+	{
+		ELobbySearchValueType Type = ELobbySearchValueType::String;
+		bool bSearchable = false;
+		int32 MaxSize = 0;
+	};
+
+	static const FOnlineSampleLobbySchema& Get();
+
+	const FAttributeDescriptor* FindAttribute(FName AttributeName) const { return Attributes.Find(AttributeName); }
+
+	/** 스키마 값을 블루프린트에 넘길 문자열로 바꿉니다 */
+	static FString VariantToString(const UE::Online::FSchemaVariant& Value);
+
+private:
+
+	FOnlineSampleLobbySchema();
+
+	TMap<FName, FAttributeDescriptor> Attributes;
+};
+
+/**
+ * 로비 검색 조건을 블루프린트에서 조립하기 위한 함수 모음입니다
+ */
+UCLASS()
+class ONLINETESTSAMPLE_API UOnlineSampleLobbyQueryLibrary : public UBlueprintFunctionLibrary
+{
+	GENERATED_BODY()
+
+public:
+
+	UFUNCTION(BlueprintCallable, Category="Lobby Search")
+	static FBlueprintLobbySearchQuery AddStringFilter(UPARAM(ref) FBlueprintLobbySearchQuery& Query, FName AttributeName, ELobbySearchComparison Comparison, const FString& Value);
+
+	UFUNCTION(BlueprintCallable, Category="Lobby Search")
+	static FBlueprintLobbySearchQuery AddIntFilter(UPARAM(ref) FBlueprintLobbySearchQuery& Query, FName AttributeName, ELobbySearchComparison Comparison, int64 Value);
+
+	UFUNCTION(BlueprintCallable, Category="Lobby Search")
+	static FBlueprintLobbySearchQuery AddDoubleFilter(UPARAM(ref) FBlueprintLobbySearchQuery& Query, FName AttributeName, ELobbySearchComparison Comparison, double Value);
+
+	UFUNCTION(BlueprintCallable, Category="Lobby Search")
+	static FBlueprintLobbySearchQuery AddBoolFilter(UPARAM(ref) FBlueprintLobbySearchQuery& Query, FName AttributeName, ELobbySearchComparison Comparison, bool Value);
+
+	UFUNCTION(BlueprintCallable, Category="Lobby Search")
+	static bool ValidateLobbySearchQuery(const FBlueprintLobbySearchQuery& Query, TArray<FString>& OutErrors);
+};
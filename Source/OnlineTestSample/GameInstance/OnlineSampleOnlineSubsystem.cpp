@@ -4,13 +4,19 @@
 #include "OnlineSampleOnlineSubsystem.h"
 
 #include "Engine/AssetManager.h"
+#include "Engine/NetDriver.h"
+#include "GameFramework/GameModeBase.h"
+#include "GameFramework/GameStateBase.h"
 //#include "GameFramework/GameSession.h"
 #include "Online/OnlineResult.h"
 #include "Online/Auth.h"
 #include "Online/Lobbies.h"
 #include "Online/OnlineAsyncOpHandle.h"
+#include "Online/OnlineErrorDefinitions.h"
 #include "Online/Presence.h"
 #include "Online/UserInfo.h"
+#include "Algo/StableSort.h"
+#include "Misc/PackageName.h"
 
 
 DEFINE_LOG_CATEGORY(LogOnlineSampleOnlineSubsystem);
@@ -48,6 +54,8 @@ void UOnlineSampleOnlineSubsystem::Initialize(FSubsystemCollectionBase& Collecti
 	BindLobbyUpdatedEvents();
 	// 현재 상태(친구창) 업데이트 될 때 호출될 함수 바인드. 우선 친구쪽. 
 	BindPresenceUpdatedEvents();
+	// 미리 읽은 레벨로 이동이 끝나면 핸들을 놓습니다
+	PostLoadMapHandle = FCoreUObjectDelegates::PostLoadMapWithWorld.AddUObject(this, &ThisClass::HandlePostLoadMapForPreload);
 }
  
 /// <summary>
@@ -59,6 +67,41 @@ void UOnlineSampleOnlineSubsystem::Deinitialize()
 
 	// 로그아웃 ㄱㄱ
 	Logout();
+	// 모아둔 알림은 버립니다
+	GetGameInstance()->GetTimerManager().ClearAllTimersForObject(this);
+	bLobbyNotifyPending = false;
+	// 미리 읽던 레벨을 놓습니다
+	FCoreUObjectDelegates::PostLoadMapWithWorld.Remove(PostLoadMapHandle);
+	CancelLobbyMapPreload();
+	if(HostMapPreloadHandle.IsValid())
+	{
+		HostMapPreloadHandle->CancelHandle();
+		HostMapPreloadHandle.Reset();
+	}
+	HostStartState.bActive = false;
+	JoinFriendState.bActive = false;
+	SessionSearchState.bActive = false;
+	HostSetupState.bActive = false;
+	// 유저 정보를 기다리던 호출자에게 빈 값을 돌려줍니다
+	for(TPair<UE::Online::FAccountId, FUserInfoCacheEntry>& CacheEntry : UserInfoCache)
+	{
+		for(TPromise<FBlueprintUserInfo>& Waiter : CacheEntry.Value.Waiters)
+		{
+			Waiter.SetValue(FBlueprintUserInfo());
+		}
+	}
+	UserInfoCache.Reset();
+	PendingUserInfoQueries.Reset();
+	LoginPipelines.Reset();
+	MultiLoginState = FMultiLoginState();
+	PendingLobbyJoins.Reset();
+	// QoS 소켓을 닫습니다
+	LobbyQosProber.Reset();
+	ManualQosProber.Reset();
+	StopQosResponder();
+	// LAN 비컨 소켓을 닫습니다
+	StopLanBeacon();
+	LanBeaconClient.Reset();
 	// 이벤트 핸들 바인딩을 해제하고 구조체 정보를 리셋합니다
 	OnlineServicesInfoInternal->Reset();
  
@@ -75,15 +118,7 @@ void UOnlineSampleOnlineSubsystem::HandleCreateLobby(
 	if(CreateLobbyResult.IsOk())
 	{
 		IsSucceeded = true;
-		CreatedLobby = CreateLobbyResult.GetOkValue().Lobby;
-		JoinedLobby = FBlueprintLobbyInfo(CreatedLobby);
-		
-		UE_LOG(LogTemp, Warning, TEXT("Create Lobby Completed"));
-
-		for(auto& Attribute: CreatedLobby.Get()->Attributes)
-		{
-			UE_LOG(LogTemp, Display, TEXT("Attribute - %s"), *Attribute.Key.ToString());
-		}
+		ApplyCreatedLobby(CreateLobbyResult.GetOkValue().Lobby);
 	}
 	else
 	{
@@ -96,6 +131,22 @@ void UOnlineSampleOnlineSubsystem::HandleCreateLobby(
 	NotifyLobbyUpdated();
 }
 
+void UOnlineSampleOnlineSubsystem::ApplyCreatedLobby(const TSharedRef<const UE::Online::FLobby>& Lobby)
+{
+	CreatedLobby = Lobby;
+	bool bIsNewEntry = false;
+	SetPrimaryLobby(UpdateLobbyState(Lobby, bIsNewEntry));
+	// 새 로비가 검색 결과에 바로 보이도록 캐시를 비웁니다.
+	InvalidateLobbySearchCache();
+	
+	UE_LOG(LogTemp, Warning, TEXT("Create Lobby Completed"));
+
+	for(auto& Attribute: CreatedLobby.Get()->Attributes)
+	{
+		UE_LOG(LogTemp, Display, TEXT("Attribute - %s"), *Attribute.Key.ToString());
+	}
+}
+
 void UOnlineSampleOnlineSubsystem::HandleFindLobbies(
 	const UE::Online::TOnlineResult<UE::Online::FFindLobbies>& FindLobbiesResult)
 {
@@ -105,11 +156,8 @@ void UOnlineSampleOnlineSubsystem::HandleFindLobbies(
 	if(FindLobbiesResult.IsOk())
 	{
 		IsSucceeded = true;
-		FoundLobbies.Empty();
-		for(TSharedRef<const FLobby> Lobby : FindLobbiesResult.GetOkValue().Lobbies)
-		{
-			FoundLobbies.Add(FBlueprintLobbyInfo(Lobby));
-		}
+		SetFoundLobbies(FindLobbiesResult.GetOkValue().Lobbies);
+		FoundLobbiesCacheKey.Reset();
 		
 		UE_LOG(LogTemp, Warning, TEXT("Find Lobby Completed"));
 	}
@@ -120,10 +168,157 @@ void UOnlineSampleOnlineSubsystem::HandleFindLobbies(
 	
 	OnFindLobbiesCompleteEvent.Broadcast(IsSucceeded);
 	K2_OnFindLobbiesCompleteEvent.Broadcast(IsSucceeded);
+
+	// 결과는 바로 보여주고, 호스트 RTT를 잰 뒤 다시 정렬합니다.
+	if(IsSucceeded && bEnableLobbyQos)
+	{
+		RankFoundLobbiesByQos();
+	}
+}
+
+void UOnlineSampleOnlineSubsystem::SetFoundLobbies(const TArray<TSharedRef<const UE::Online::FLobby>>& Lobbies)
+{
+	// 다시 받은 로비도 QoS 정렬이 끝나기 전까지 이전에 잰 RTT로 보이게 합니다.
+	TMap<UE::Online::FLobbyId, float> MeasuredPings;
+	for(const FBlueprintLobbyInfo& LobbyInfo : FoundLobbies)
+	{
+		if(LobbyInfo.Lobby.IsValid() && LobbyInfo.PingMs >= 0.f)
+		{
+			MeasuredPings.Add(LobbyInfo.Lobby->LobbyId, LobbyInfo.PingMs);
+		}
+	}
+	
+	// 이전 검색 결과의 할당은 재사용합니다.
+	FoundLobbies.Reset(Lobbies.Num());
+	for(const TSharedRef<const UE::Online::FLobby>& Lobby : Lobbies)
+	{
+		FBlueprintLobbyInfo& LobbyInfo = FoundLobbies.Add_GetRef(FBlueprintLobbyInfo(Lobby));
+		if(const float* PingMs = MeasuredPings.Find(Lobby->LobbyId))
+		{
+			LobbyInfo.PingMs = *PingMs;
+		}
+	}
+}
+
+void UOnlineSampleOnlineSubsystem::HandleCachedFindLobbies(
+	const UE::Online::TOnlineResult<UE::Online::FFindLobbies>& FindLobbiesResult, const FString& CacheKey)
+{
+	using namespace UE::Online;
+
+	FLobbySearchCacheEntry& CacheEntry = LobbySearchCache.FindOrAdd(CacheKey);
+	CacheEntry.bRefreshInFlight = false;
+	const bool bIsLatestSearch = CacheEntry.SearchSerial == LobbySearchSerial;
+	const bool bServedFromCache = CacheEntry.bServedFromCache;
+
+	// 그 사이에 다른 검색을 시작했다면 캐시만 갱신하고 FoundLobbies는 건드리지 않습니다.
+	if(bIsLatestSearch && !bServedFromCache)
+	{
+		HandleFindLobbies(FindLobbiesResult);
+		if(FindLobbiesResult.IsOk())
+		{
+			CacheEntry.Results = FoundLobbies;
+			FoundLobbiesCacheKey = CacheKey;
+		}
+	}
+	else if(bIsLatestSearch && FindLobbiesResult.IsOk())
+	{
+		// 캐시된 목록은 이미 보여줬으니 완료 이벤트 대신 갱신 이벤트를 보냅니다.
+		SetFoundLobbies(FindLobbiesResult.GetOkValue().Lobbies);
+		CacheEntry.Results = FoundLobbies;
+		FoundLobbiesCacheKey = CacheKey;
+		
+		OnFoundLobbiesRefreshedEvent.Broadcast();
+		K2_OnFoundLobbiesRefreshedEvent.Broadcast();
+		if(bEnableLobbyQos)
+		{
+			RankFoundLobbiesByQos();
+		}
+	}
+	else if(FindLobbiesResult.IsOk())
+	{
+		CacheEntry.Results.Reset(FindLobbiesResult.GetOkValue().Lobbies.Num());
+		for(const TSharedRef<const FLobby>& Lobby : FindLobbiesResult.GetOkValue().Lobbies)
+		{
+			CacheEntry.Results.Add(FBlueprintLobbyInfo(Lobby));
+		}
+	}
+
+	if(FindLobbiesResult.IsOk())
+	{
+		CacheEntry.FetchedTime = FPlatformTime::Seconds();
+	}
+	else if(CacheEntry.FetchedTime == 0.0)
+	{
+		LobbySearchCache.Remove(CacheKey);
+	}
+}
+
+void UOnlineSampleOnlineSubsystem::HandleFindLobbiesPage(
+	const UE::Online::TOnlineResult<UE::Online::FFindLobbies>& FindLobbiesResult, uint32 SearchSerial)
+{
+	using namespace UE::Online;
+
+	// 취소되었거나 새 검색으로 대체된 커서의 응답은 버립니다.
+	if(SearchSerial != LobbySearchSerial || !LobbySearchCursor.bSearchInFlight)
+	{
+		return;
+	}
+	
+	LobbySearchCursor.bSearchInFlight = false;
+	if(FindLobbiesResult.IsError())
+	{
+		LobbySearchCursor.bExhausted = true;
+		UE_LOG(LogOnlineSampleOnlineSubsystem, Error, TEXT("Find Lobbies Paged Failed : %s"), *FindLobbiesResult.GetErrorValue().GetLogString());
+		OnFindLobbiesCompleteEvent.Broadcast(false);
+		K2_OnFindLobbiesCompleteEvent.Broadcast(false);
+		return;
+	}
+
+	LobbySearchCursor.Results = FindLobbiesResult.GetOkValue().Lobbies;
+
+	// 첫 페이지는 바로 붙이고, 자동 스트리밍이면 남은 페이지도 이어서 붙입니다.
+	// 페이지 이벤트 안에서 새 검색을 시작했으면 거기서 멈춥니다.
+	do
+	{
+		AppendNextLobbyPage();
+	}
+	while(LobbySearchCursor.bAutoStream && !LobbySearchCursor.bExhausted && SearchSerial == LobbySearchSerial);
+}
+
+void UOnlineSampleOnlineSubsystem::AppendNextLobbyPage()
+{
+	const int32 PageIndex = LobbySearchCursor.NextPageIndex;
+	const int32 FirstNewIndex = FoundLobbies.Num();
+	const int32 NumNewLobbies = FMath::Clamp(LobbySearchCursor.Results.Num() - LobbySearchCursor.NextResultIndex, 0, LobbySearchCursor.PageSize);
+	
+	for(int32 Offset = 0; Offset < NumNewLobbies; ++Offset)
+	{
+		FoundLobbies.Add(FBlueprintLobbyInfo(LobbySearchCursor.Results[LobbySearchCursor.NextResultIndex + Offset]));
+	}
+	LobbySearchCursor.NextResultIndex += NumNewLobbies;
+	++LobbySearchCursor.NextPageIndex;
+	
+	const bool bIsLastPage = LobbySearchCursor.NextResultIndex >= LobbySearchCursor.Results.Num() || LobbySearchCursor.NextPageIndex >= MaxLobbySearchPages;
+	LobbySearchCursor.bExhausted = bIsLastPage;
+	if(bIsLastPage)
+	{
+		LobbySearchCursor.Results.Empty();
+	}
+	
+	UE_LOG(LogOnlineSampleOnlineSubsystem, Log, TEXT("Find Lobbies Page %d Appended : %d New, %d Total"), PageIndex, NumNewLobbies, FoundLobbies.Num());
+	
+	OnFindLobbiesPageReceivedEvent.Broadcast(PageIndex, FirstNewIndex, NumNewLobbies, bIsLastPage);
+	K2_OnFindLobbiesPageReceivedEvent.Broadcast(PageIndex, FirstNewIndex, NumNewLobbies, bIsLastPage);
+	
+	if(bIsLastPage)
+	{
+		OnFindLobbiesCompleteEvent.Broadcast(true);
+		K2_OnFindLobbiesCompleteEvent.Broadcast(true);
+	}
 }
 
 void UOnlineSampleOnlineSubsystem::HandleJoinLobby(
-	const UE::Online::TOnlineResult<UE::Online::FJoinLobby>& JoinLobbyResult)
+	const UE::Online::TOnlineResult<UE::Online::FJoinLobby>& JoinLobbyResult, UE::Online::FAccountId JoiningAccountId)
 {
 	using namespace UE::Online;
 	
@@ -133,11 +328,24 @@ void UOnlineSampleOnlineSubsystem::HandleJoinLobby(
 	if(JoinLobbyResult.IsOk())
 	{
 		IsSucceeded = true;
-		LobbyInfo = FBlueprintLobbyInfo(JoinLobbyResult.GetOkValue().Lobby);
+		bool bIsNewEntry = false;
+		FLobbyStateEntry& Entry = UpdateLobbyState(JoinLobbyResult.GetOkValue().Lobby, bIsNewEntry);
+		SetPrimaryLobby(Entry);
+		LobbyInfo = Entry.Info;
 
-		//우선 임시로 로컬 플레이어 이렇게 얻기.
-		
-		TravelToLobby(GetWorld()->GetFirstLocalPlayerFromController(), LobbyInfo);
+		// 접속하는 동안 목적지 레벨을 같이 읽어둡니다.
+		PreloadLobbyMap(LobbyInfo);
+
+		// 스플릿스크린에서는 첫 번째 플레이어가 아니라 참가를 요청한 플레이어로 이동합니다.
+		const FLobby& Lobby = *JoinLobbyResult.GetOkValue().Lobby;
+		if(const TSharedRef<const FLobbyMember>* LobbyMember = Lobby.Members.Find(JoiningAccountId))
+		{
+			LocalPlayerLobbyMemberInfo = FBlueprintLobbyMemberInfo(LobbyMember->Get(), Lobby.OwnerAccountId == JoiningAccountId);
+		}
+		if(ULocalPlayer* JoiningPlayer = FindLocalPlayerByAccountId(JoiningAccountId))
+		{
+			TravelToLobby(JoiningPlayer, LobbyInfo);
+		}
 		
 		UE_LOG(LogTemp, Warning, TEXT("Join Lobby Completed"));
 	}
@@ -157,21 +365,28 @@ void UOnlineSampleOnlineSubsystem::HandleGetFriends(
 {
 	using namespace UE::Online;
 
-	FoundFriends.Empty();
-	
+	// 실패하면 이전 목록을 그대로 둡니다.
 	if(GetFriendsResult.IsOk())
 	{
 		UE_LOG(LogTemp, Warning, TEXT("Get Friends Success"));
-		
-		for(TSharedRef<FFriend> Friend : GetFriendsResult.GetOkValue().Friends)
+
+		// 지우고 다시 채우지 않고 새 결과와 비교해서 바뀐 슬롯만 고칩니다. 저장소는 필요한 값만 복사하므로 결과가 사라져도 안전합니다.
+		FBlueprintFriendRosterDelta RosterDelta;
+		FriendRoster.Sync(GetFriendsResult.GetOkValue().Friends, RosterDelta.AddedFriendIds, RosterDelta.RemovedFriendIds, RosterDelta.ChangedFriendIds);
+
+		for(const int32 RemovedFriendId : RosterDelta.RemovedFriendIds)
 		{
-			FoundFriends.Emplace(Friend.Get().FriendId.GetHandle(), FBlueprintFriendInfo(&Friend.Get()));
-			UE_LOG(LogTemp, Display, TEXT("Found Friend DisplayName : %s"), *Friend.Get().DisplayName);//
-			UE_LOG(LogTemp, Display, TEXT("Found Friend NickName: %s"), *Friend.Get().Nickname);//
-			UE_LOG(LogTemp, Display, TEXT("Found Friend Id: %d"), Friend.Get().FriendId.GetHandle());//
-			//
+			FriendPresences.Remove(RemovedFriendId);
 		}
+
+		UE_LOG(LogOnlineSampleOnlineSubsystem, Log, TEXT("Friend roster synced : %d friends, +%d -%d ~%d"), FriendRoster.Num(),
+			RosterDelta.AddedFriendIds.Num(), RosterDelta.RemovedFriendIds.Num(), RosterDelta.ChangedFriendIds.Num());
 		
+		if(!RosterDelta.IsEmpty())
+		{
+			OnFriendRosterChangedEvent.Broadcast(RosterDelta);
+			K2_OnFriendRosterChangedEvent.Broadcast(RosterDelta);
+		}
 	}
 	else
 	{
@@ -184,25 +399,61 @@ void UOnlineSampleOnlineSubsystem::HandleGetFriends(
 }
 
 void UOnlineSampleOnlineSubsystem::HandleGetUserInfo(
-	const UE::Online::TOnlineResult<UE::Online::FGetUserInfo>& GetUserInfoResult)
+	const UE::Online::TOnlineResult<UE::Online::FGetUserInfo>& GetUserInfoResult, const UE::Online::FAccountId& TargetUser)
 {
 	using namespace UE::Online;
 
-	if(GetUserInfoResult.IsOk())
+	FUserInfoCacheEntry* CacheEntry = UserInfoCache.Find(TargetUser);
+	if(!CacheEntry)
 	{
-		
-		FoundUsers.Add(&GetUserInfoResult.GetOkValue().UserInfo.Get());
-		UE_LOG(LogTemp, Warning, TEXT("Get User Info Success"));
+		return;
+	}
+
+	CacheEntry->bQueryInFlight = false;
+	TArray<TPromise<FBlueprintUserInfo>> Waiters = MoveTemp(CacheEntry->Waiters);
+	CacheEntry->Waiters.Reset();
+	
+	const bool bSucceeded = GetUserInfoResult.IsOk();
+	FBlueprintUserInfo ResolvedInfo;
+	if(bSucceeded)
+	{
+		ResolvedInfo = FBlueprintUserInfo(GetUserInfoResult.GetOkValue().UserInfo.Get());
+		CacheEntry->Info = ResolvedInfo;
+		CacheEntry->FetchedTime = FPlatformTime::Seconds();
 
-		//
-		UE_LOG(LogTemp, Display, TEXT("User Info ID : %d"), GetUserInfoResult.GetOkValue().UserInfo.Get().AccountId.GetHandle());
-		UE_LOG(LogTemp, Display, TEXT("User Info DisplayName : %s"), *GetUserInfoResult.GetOkValue().UserInfo.Get().DisplayName);
-		//
+		// FoundUsers는 지우지 않고 같은 계정이면 제자리에서 갱신합니다.
+		if(FBlueprintUserInfo* FoundUser = FoundUsers.FindByPredicate([&ResolvedInfo](const FBlueprintUserInfo& UserInfo) { return UserInfo.UserId == ResolvedInfo.UserId; }))
+		{
+			*FoundUser = ResolvedInfo;
+		}
+		else
+		{
+			FoundUsers.Add(ResolvedInfo);
+		}
+		UE_LOG(LogOnlineSampleOnlineSubsystem, Verbose, TEXT("User Info %d resolved : %s"), ResolvedInfo.UserId, *ResolvedInfo.DisplayName);
 	}
 	else
 	{
 		UE_LOG(LogTemp, Error, TEXT("Get User Info Failed : %s"), *GetUserInfoResult.GetErrorValue().GetLogString());
+		// 받은 적 없는 계정이 실패하면 항목을 지워서 다음 요청이 다시 묻게 합니다.
+		// 갱신만 실패했으면 빈 값 대신 예전에 받은 값을 돌려줍니다.
+		if(CacheEntry->FetchedTime <= 0.0)
+		{
+			UserInfoCache.Remove(TargetUser);
+		}
+		else
+		{
+			ResolvedInfo = CacheEntry->Info;
+		}
+	}
+
+	for(TPromise<FBlueprintUserInfo>& Waiter : Waiters)
+	{
+		Waiter.SetValue(ResolvedInfo);
 	}
+	
+	OnUserInfoResolvedEvent.Broadcast(bSucceeded, ResolvedInfo);
+	K2_OnUserInfoResolvedEvent.Broadcast(bSucceeded, ResolvedInfo);
 }
 
 void UOnlineSampleOnlineSubsystem::BindPresenceUpdatedEvents()
@@ -225,168 +476,662 @@ void UOnlineSampleOnlineSubsystem::HandleFriendsUpdated(const UE::Online::FPrese
 	using namespace UE::Online;
 
 	const FUserPresence& UpdatedPresence =  DataUpdated.UpdatedPresence.Get();
-	UE_LOG(LogTemp, Warning, TEXT("User %d Has Been Updated"), UpdatedPresence.AccountId.GetHandle());
+	UE_LOG(LogOnlineSampleOnlineSubsystem, Verbose, TEXT("User %d Has Been Updated"), UpdatedPresence.AccountId.GetHandle());
 
-	if(FoundFriends.Contains(UpdatedPresence.AccountId.GetHandle()))
+	// 친구 목록에 있는 계정만 저장합니다.
+	if(FriendRoster.FindSlot(UpdatedPresence.AccountId.GetHandle()) != INDEX_NONE)
 	{
-		UE_LOG(LogTemp, Warning, TEXT("Testing-%d"), FoundFriends.Find(UpdatedPresence.AccountId.GetHandle())->FriendId);	
+		UpdateFriendPresence(UpdatedPresence);
 	}
-	
-	
 }
 
-void UOnlineSampleOnlineSubsystem::AdjustLobbyAfterStart(ULocalPlayer* LocalPlayer, FBlueprintLobbyInfo LobbyInfo)
+void UOnlineSampleOnlineSubsystem::UpdateFriendPresence(const UE::Online::FUserPresence& Presence)
 {
-	using namespace UE::Online;
+	const FBlueprintPresenceInfo NewPresenceInfo(Presence);
+	const int32 AccountHandle = NewPresenceInfo.AccountHandle;
+
+	if(const int32* Index = FriendPresences.Indices.Find(AccountHandle))
+	{
+		FBlueprintPresenceInfo& StoredPresenceInfo = FriendPresences.Entries[*Index];
+		if(StoredPresenceInfo.HasSameState(NewPresenceInfo))
+		{
+			return;
+		}
+		StoredPresenceInfo = NewPresenceInfo;
+	}
+	else
+	{
+		FriendPresences.Indices.Add(AccountHandle, FriendPresences.Entries.Add(NewPresenceInfo));
+	}
+
+	// 그 친구를 구독한 쪽에만 알립니다. 목록 전체를 다시 그릴 필요가 없습니다.
+	if(const FFriendPresenceUpdated* Handlers = FriendPresenceHandlers.Find(AccountHandle))
+	{
+		Handlers->Broadcast(NewPresenceInfo);
+	}
+	if(const TArray<FFriendPresenceHandler_Dynamic>* K2_Handlers = K2_FriendPresenceHandlers.Find(AccountHandle))
+	{
+		// 핸들러 안에서 구독을 바꿔도 안전하도록 복사해서 돌립니다.
+		for(const FFriendPresenceHandler_Dynamic& Handler : TArray<FFriendPresenceHandler_Dynamic>(*K2_Handlers))
+		{
+			Handler.ExecuteIfBound(NewPresenceInfo);
+		}
+	}
 	
-	if(ILobbiesPtr LobbiesInterface = OnlineServicesInfoInternal->LobbiesInterface)
+	OnFriendPresenceUpdatedEvent.Broadcast(NewPresenceInfo);
+	K2_OnFriendPresenceUpdatedEvent.Broadcast(NewPresenceInfo);
+}
+
+void UOnlineSampleOnlineSubsystem::GetFriendInfos(TArray<FBlueprintFriendInfo>& OutFriendInfos) const
+{
+	OutFriendInfos.Reset(FriendRoster.Num());
+	for(int32 Slot = 0; Slot < FriendRoster.GetSlotCapacity(); ++Slot)
 	{
-		FModifyLobbyAttributes::Params ModifyLobbyParams;
-		ModifyLobbyParams.UpdatedAttributes.Emplace(FName(TEXT("MATCHSTATE")), FString(TEXT("Starting")));
-		ModifyLobbyParams.LobbyId = LobbyInfo.Lobby->LobbyId;
-		ModifyLobbyParams.LocalAccountId = GetOnlineUserInfo(LocalPlayer->GetPlatformUserId())->AccountId;
-		
-		LobbiesInterface->ModifyLobbyAttributes(MoveTemp(ModifyLobbyParams)).OnComplete([this, LocalPlayer, LobbyInfo, LobbiesInterface]
-			(TOnlineResult<FModifyLobbyAttributes> ModifyLobbyAttributesResult)
+		if(FriendRoster.IsValidSlot(Slot))
 		{
-			if(ModifyLobbyAttributesResult.IsOk())
-			{
-				FModifyLobbyMemberAttributes::Params ModifyLobbyMemberParams;
-				ModifyLobbyMemberParams.LobbyId = LobbyInfo.Lobby->LobbyId;
-				ModifyLobbyMemberParams.UpdatedAttributes.Emplace(FName(TEXT("MATCHSTATE")), FString(TEXT("Starting")));
-				ModifyLobbyMemberParams.LocalAccountId = GetOnlineUserInfo(LocalPlayer->GetPlatformUserId())->AccountId;
-				
-				LobbiesInterface->ModifyLobbyMemberAttributes(MoveTemp(ModifyLobbyMemberParams)).OnComplete([this](TOnlineResult<FModifyLobbyMemberAttributes> ModifyLobbyMemberAttributesResult)
-				{
-					if(ModifyLobbyMemberAttributesResult.IsOk())
-					{
-						// if(MyMap.IsValid())
-						// {
-							
-						// }
-						// else
-						// {
-						// 	UE_LOG(LogTemp, Error, TEXT("Map is invalid"));
-						// }
-						
-					}
-				});
-			}
-			else
-			{
-				UE_LOG(LogTemp, Error, TEXT("Modify Lobby Attributes Failed : %s"), *ModifyLobbyAttributesResult.GetErrorValue().GetLogString());
-			}
-		});
-		
+			OutFriendInfos.Emplace(FriendRoster, Slot);
+		}
 	}
 }
 
-void UOnlineSampleOnlineSubsystem::HandleCreateSession(
-	const UE::Online::TOnlineResult<UE::Online::FCreateSession>& CreateSessionResult)
+bool UOnlineSampleOnlineSubsystem::GetFriendInfo(int32 FriendId, FBlueprintFriendInfo& OutFriendInfo) const
 {
-	using namespace UE::Online;
+	const int32 Slot = FriendRoster.FindSlot(FriendId);
+	if(Slot == INDEX_NONE)
+	{
+		return false;
+	}
+	
+	OutFriendInfo = FBlueprintFriendInfo(FriendRoster, Slot);
+	return true;
+}
 
-	if(CreateSessionResult.IsOk())
+bool UOnlineSampleOnlineSubsystem::GetFriendPresence(int32 FriendId, FBlueprintPresenceInfo& OutPresenceInfo) const
+{
+	if(const FBlueprintPresenceInfo* PresenceInfo = FriendPresences.Find(FriendId))
 	{
-		UE_LOG(LogTemp, Warning, TEXT("Session Creation Success"));
+		OutPresenceInfo = *PresenceInfo;
+		return true;
 	}
-	else
+	return false;
+}
+
+FDelegateHandle UOnlineSampleOnlineSubsystem::AddFriendPresenceHandler(int32 FriendId, FFriendPresenceUpdated::FDelegate&& Handler)
+{
+	return FriendPresenceHandlers.FindOrAdd(FriendId).Add(MoveTemp(Handler));
+}
+
+bool UOnlineSampleOnlineSubsystem::RemoveFriendPresenceHandler(int32 FriendId, FDelegateHandle Handle)
+{
+	FFriendPresenceUpdated* Handlers = FriendPresenceHandlers.Find(FriendId);
+	if(!Handlers || !Handlers->Remove(Handle))
 	{
-		UE_LOG(LogTemp, Error, TEXT("Session Creation Failed : %s"), *CreateSessionResult.GetErrorValue().GetLogString());
+		return false;
+	}
+	if(!Handlers->IsBound())
+	{
+		FriendPresenceHandlers.Remove(FriendId);
 	}
+	return true;
 }
 
-void UOnlineSampleOnlineSubsystem::BindLobbyUpdatedEvents()
+void UOnlineSampleOnlineSubsystem::K2_SubscribeFriendPresence(int32 FriendId, FFriendPresenceHandler_Dynamic Handler)
 {
-	using namespace UE::Online;
-	
-	if(ILobbiesPtr LobbiesInterface = OnlineServicesInfoInternal->LobbiesInterface)
+	if(Handler.IsBound())
 	{
-		LobbyMemberChangeEvent_Handles.Add(LobbiesInterface->OnLobbyMemberJoined().Add(this, &ThisClass::HandleMemberJoinedLobby));
-		LobbyMemberChangeEvent_Handles.Add(LobbiesInterface->OnLobbyMemberLeft().Add(this, &ThisClass::HandleMemberLeftLobby));
-		LobbyMemberChangeEvent_Handles.Add(LobbiesInterface->OnLobbyJoined().Add(this, &ThisClass::HandleJoinedLobby));
-		LobbyMemberChangeEvent_Handles.Add(LobbiesInterface->OnLobbyLeft().Add(this, &ThisClass::HandleLeftLobby));
-		LobbyMemberChangeEvent_Handles.Add(LobbiesInterface->OnLobbyAttributesChanged().Add(this, &ThisClass::HandleLobbyAttributeChanged));
+		K2_FriendPresenceHandlers.FindOrAdd(FriendId).AddUnique(Handler);
 	}
-	else
+}
+
+void UOnlineSampleOnlineSubsystem::K2_UnsubscribeFriendPresence(int32 FriendId, FFriendPresenceHandler_Dynamic Handler)
+{
+	if(TArray<FFriendPresenceHandler_Dynamic>* Handlers = K2_FriendPresenceHandlers.Find(FriendId))
 	{
-		UE_LOG(LogTemp, Error, TEXT("Online Services Lobbies Interface is NOT VALID"));
+		Handlers->Remove(Handler);
+		if(Handlers->IsEmpty())
+		{
+			K2_FriendPresenceHandlers.Remove(FriendId);
+		}
 	}
 }
 
-const void UOnlineSampleOnlineSubsystem::NotifyLobbyUpdated()
+void UOnlineSampleOnlineSubsystem::AdjustLobbyAfterStart(ULocalPlayer* LocalPlayer, FBlueprintLobbyInfo LobbyInfo, TFunction<void(bool bSucceeded)>&& OnComplete)
 {
-	UE_LOG(LogTemp, Display, TEXT("NotifyLobbyUpdated"));
-	
-	OnLobbyInfoUpdatedEvent.Broadcast(JoinedLobby);
-	K2_OnLobbyInfoUpdatedEvent.Broadcast(JoinedLobby);
+	using namespace UE::Online;
+
+	// 로비 속성과 멤버 속성을 한 번에 보내서 왕복 한 번으로 끝냅니다.
+	const FLobbyId LobbyId = LobbyInfo.Lobby->LobbyId;
+	QueueLobbyAttribute(LocalPlayer, LobbyId, FName(TEXT("MATCHSTATE")), FString(TEXT("Starting")));
+	QueueLobbyMemberAttribute(LocalPlayer, LobbyId, FName(TEXT("MATCHSTATE")), FString(TEXT("Starting")));
+	FlushLobbyAttributeWrites(MoveTemp(OnComplete));
 }
 
-void UOnlineSampleOnlineSubsystem::HandleMemberJoinedLobby(const UE::Online::FLobbyMemberJoined& Info)
+void UOnlineSampleOnlineSubsystem::K2_QueueLobbyAttribute(ULocalPlayer* LocalPlayer, const FBlueprintLobbyInfo& LobbyInfo, FName AttributeName, const FString& Value)
 {
-	UE_LOG(LogTemp, Display, TEXT("HandleMemberJoinedLobby"));
-	
-	JoinedLobby = FBlueprintLobbyInfo(Info.Lobby);
-	NotifyLobbyUpdated();
+	check(LobbyInfo.Lobby.IsValid());
+	QueueLobbyAttribute(LocalPlayer, LobbyInfo.Lobby->LobbyId, AttributeName, UE::Online::FSchemaVariant(Value));
 }
 
-void UOnlineSampleOnlineSubsystem::HandleMemberLeftLobby(const UE::Online::FLobbyMemberLeft& Info)
+void UOnlineSampleOnlineSubsystem::K2_QueueLobbyMemberAttribute(ULocalPlayer* LocalPlayer, const FBlueprintLobbyInfo& LobbyInfo, FName AttributeName, const FString& Value)
 {
-	UE_LOG(LogTemp, Display, TEXT("HandleMemberLeftLobby"));
-	
-	JoinedLobby = FBlueprintLobbyInfo(Info.Lobby);
-	NotifyLobbyUpdated();
+	check(LobbyInfo.Lobby.IsValid());
+	QueueLobbyMemberAttribute(LocalPlayer, LobbyInfo.Lobby->LobbyId, AttributeName, UE::Online::FSchemaVariant(Value));
 }
 
-void UOnlineSampleOnlineSubsystem::HandleJoinedLobby(const UE::Online::FLobbyJoined& Info)
+UOnlineSampleOnlineSubsystem::FPendingLobbyAttributeWrite* UOnlineSampleOnlineSubsystem::FindOrAddPendingLobbyWrite(ULocalPlayer* LocalPlayer, const UE::Online::FLobbyId& LobbyId)
 {
-	using namespace UE::Online;
+	check(LocalPlayer);
 	
-	UE_LOG(LogTemp, Display, TEXT("Handle Joined Lobby"));
+	const UOnlineUserInfo* OnlineUser = GetOnlineUserInfo(LocalPlayer->GetPlatformUserId());
+	if(!OnlineUser)
+	{
+		return nullptr;
+	}
 
-	JoinedLobby = FBlueprintLobbyInfo(Info.Lobby);
+	// 이번 프레임에 쌓인 쓰기는 다음 프레임에 한 번에 보냅니다.
+	FTimerManager& TimerManager = GetGameInstance()->GetTimerManager();
+	if(!TimerManager.TimerExists(LobbyAttributeFlushTimerHandle))
+	{
+		LobbyAttributeFlushTimerHandle = TimerManager.SetTimerForNextTick(this, &ThisClass::HandleLobbyAttributeFlushTimer);
+	}
 	
-	FAccountId LocalPlayerAccountId = GetOnlineUserInfo( GetWorld()->GetFirstLocalPlayerFromController()->GetPlatformUserId())->AccountId;
-	if( Info.Lobby.Get().Members.Contains(LocalPlayerAccountId))
+	return &PendingLobbyAttributeWrites.FindOrAdd(TPair<UE::Online::FLobbyId, UE::Online::FAccountId>(LobbyId, OnlineUser->AccountId));
+}
+
+void UOnlineSampleOnlineSubsystem::QueueLobbyAttribute(ULocalPlayer* LocalPlayer, const UE::Online::FLobbyId& LobbyId, UE::Online::FSchemaAttributeId AttributeName, UE::Online::FSchemaVariant Value)
+{
+	if(FPendingLobbyAttributeWrite* PendingWrite = FindOrAddPendingLobbyWrite(LocalPlayer, LobbyId))
 	{
-		const FLobbyMember LobbyMember = (Info.Lobby.Get().Members.Find(LocalPlayerAccountId))->Get();
-		LocalPlayerLobbyMemberInfo = FBlueprintLobbyMemberInfo(LobbyMember, Info.Lobby.Get().OwnerAccountId == LocalPlayerAccountId);
+		PendingWrite->RemovedLobbyAttributes.Remove(AttributeName);
+		PendingWrite->LobbyAttributes.Add(AttributeName, MoveTemp(Value));
+	}
+}
 
+void UOnlineSampleOnlineSubsystem::QueueLobbyAttributeRemoval(ULocalPlayer* LocalPlayer, const UE::Online::FLobbyId& LobbyId, UE::Online::FSchemaAttributeId AttributeName)
+{
+	if(FPendingLobbyAttributeWrite* PendingWrite = FindOrAddPendingLobbyWrite(LocalPlayer, LobbyId))
+	{
+		PendingWrite->LobbyAttributes.Remove(AttributeName);
+		PendingWrite->RemovedLobbyAttributes.Add(AttributeName);
 	}
-	
-	NotifyLobbyUpdated();
 }
 
-void UOnlineSampleOnlineSubsystem::HandleLeftLobby(const UE::Online::FLobbyLeft& Info)
+void UOnlineSampleOnlineSubsystem::QueueLobbyMemberAttribute(ULocalPlayer* LocalPlayer, const UE::Online::FLobbyId& LobbyId, UE::Online::FSchemaAttributeId AttributeName, UE::Online::FSchemaVariant Value)
 {
-	UE_LOG(LogTemp, Display, TEXT("Handle Left Lobby"));
+	if(FPendingLobbyAttributeWrite* PendingWrite = FindOrAddPendingLobbyWrite(LocalPlayer, LobbyId))
+	{
+		PendingWrite->RemovedMemberAttributes.Remove(AttributeName);
+		PendingWrite->MemberAttributes.Add(AttributeName, MoveTemp(Value));
+	}
+}
 
-	JoinedLobby = FBlueprintLobbyInfo();
-	CreatedLobby = nullptr;
-	LocalPlayerLobbyMemberInfo = FBlueprintLobbyMemberInfo();
-		
-	NotifyLobbyUpdated();
+void UOnlineSampleOnlineSubsystem::QueueLobbyMemberAttributeRemoval(ULocalPlayer* LocalPlayer, const UE::Online::FLobbyId& LobbyId, UE::Online::FSchemaAttributeId AttributeName)
+{
+	if(FPendingLobbyAttributeWrite* PendingWrite = FindOrAddPendingLobbyWrite(LocalPlayer, LobbyId))
+	{
+		PendingWrite->MemberAttributes.Remove(AttributeName);
+		PendingWrite->RemovedMemberAttributes.Add(AttributeName);
+	}
 }
 
-void UOnlineSampleOnlineSubsystem::HandleLobbyAttributeChanged(const UE::Online::FLobbyAttributesChanged& Info)
+void UOnlineSampleOnlineSubsystem::HandleLobbyAttributeFlushTimer()
+{
+	FlushLobbyAttributeWrites();
+}
+
+/// <summary>
+/// 큐에 쌓인 속성 쓰기를 로비마다 최대 두 개(로비 속성, 멤버 속성)의 요청으로 동시에 보냅니다
+/// </summary>
+/// <param name="OnComplete">모든 요청이 끝난 뒤 한 번 불립니다. 하나라도 실패하면 false입니다</param>
+void UOnlineSampleOnlineSubsystem::FlushLobbyAttributeWrites(TFunction<void(bool bSucceeded)>&& OnComplete)
 {
 	using namespace UE::Online;
-	
-	UE_LOG(LogTemp, Display, TEXT("Handle Lobby Attributes Change"));
 
-	// // 로비에서 게임이 시작되는 경우.
-	// if(Info.ChangedAttributes.Contains(FName(TEXT("MATCHSTATE"))))
-	// {
-	// 	FString PrevMatchState = Info.ChangedAttributes.Find(FName(TEXT("MATCHSTATE")))->Key.GetString();
-	// 	FString PostMatchState = Info.ChangedAttributes.Find(FName(TEXT("MATCHSTATE")))->Value.GetString();
-	//
-	// 	if(PrevMatchState.Equals(FString(TEXT("Waiting")))  && PostMatchState.Equals(FString(TEXT("Starting")))
-	// 		&& !LocalPlayerLobbyMemberInfo.bIsLobbyOwner)
-	// 	{
-	// 		TravelToLobby(GetWorld()->GetFirstLocalPlayerFromController(), JoinedLobby);
-	// 	}else
-	// 	{
-	// 		if(!PrevMatchState.Equals(FString(TEXT("Waiting"))))
+	GetGameInstance()->GetTimerManager().ClearTimer(LobbyAttributeFlushTimerHandle);
+
+	ILobbiesPtr LobbiesInterface = OnlineServicesInfoInternal->LobbiesInterface;
+	if(!LobbiesInterface || PendingLobbyAttributeWrites.IsEmpty())
+	{
+		PendingLobbyAttributeWrites.Reset();
+		if(OnComplete)
+		{
+			OnComplete(LobbiesInterface.IsValid());
+		}
+		return;
+	}
+
+	// 동시에 보낸 요청들이 모두 끝났는지 세는 상태입니다.
+	struct FFlushState
+	{
+		int32 NumRemaining = 0;
+		bool bAllSucceeded = true;
+		TFunction<void(bool)> OnComplete;
+	};
+	TSharedRef<FFlushState> FlushState = MakeShared<FFlushState>();
+	FlushState->OnComplete = MoveTemp(OnComplete);
+
+	auto OnRequestComplete = [FlushState](bool bSucceeded, const FOnlineError* Error)
+	{
+		if(!bSucceeded)
+		{
+			FlushState->bAllSucceeded = false;
+			UE_LOG(LogOnlineSampleOnlineSubsystem, Error, TEXT("Modify Lobby Attributes Failed : %s"), *Error->GetLogString());
+		}
+		if(--FlushState->NumRemaining == 0 && FlushState->OnComplete)
+		{
+			FlushState->OnComplete(FlushState->bAllSucceeded);
+		}
+	};
+
+	TMap<TPair<FLobbyId, FAccountId>, FPendingLobbyAttributeWrite> Writes = MoveTemp(PendingLobbyAttributeWrites);
+	PendingLobbyAttributeWrites.Reset();
+	
+	for(const auto& Tuple : Writes)
+	{
+		if(!Tuple.Value.LobbyAttributes.IsEmpty() || !Tuple.Value.RemovedLobbyAttributes.IsEmpty())
+		{
+			++FlushState->NumRemaining;
+		}
+		if(!Tuple.Value.MemberAttributes.IsEmpty() || !Tuple.Value.RemovedMemberAttributes.IsEmpty())
+		{
+			++FlushState->NumRemaining;
+		}
+	}
+	if(FlushState->NumRemaining == 0)
+	{
+		if(FlushState->OnComplete)
+		{
+			FlushState->OnComplete(true);
+		}
+		return;
+	}
+
+	for(auto& Tuple : Writes)
+	{
+		FPendingLobbyAttributeWrite& PendingWrite = Tuple.Value;
+		
+		if(!PendingWrite.LobbyAttributes.IsEmpty() || !PendingWrite.RemovedLobbyAttributes.IsEmpty())
+		{
+			FModifyLobbyAttributes::Params ModifyLobbyParams;
+			ModifyLobbyParams.LobbyId = Tuple.Key.Key;
+			ModifyLobbyParams.LocalAccountId = Tuple.Key.Value;
+			ModifyLobbyParams.UpdatedAttributes = MoveTemp(PendingWrite.LobbyAttributes);
+			ModifyLobbyParams.RemovedAttributes = MoveTemp(PendingWrite.RemovedLobbyAttributes);
+			
+			LobbiesInterface->ModifyLobbyAttributes(MoveTemp(ModifyLobbyParams)).OnComplete([OnRequestComplete](const TOnlineResult<FModifyLobbyAttributes>& Result)
+			{
+				OnRequestComplete(Result.IsOk(), Result.IsError() ? &Result.GetErrorValue() : nullptr);
+			});
+		}
+		
+		if(!PendingWrite.MemberAttributes.IsEmpty() || !PendingWrite.RemovedMemberAttributes.IsEmpty())
+		{
+			FModifyLobbyMemberAttributes::Params ModifyLobbyMemberParams;
+			ModifyLobbyMemberParams.LobbyId = Tuple.Key.Key;
+			ModifyLobbyMemberParams.LocalAccountId = Tuple.Key.Value;
+			ModifyLobbyMemberParams.UpdatedAttributes = MoveTemp(PendingWrite.MemberAttributes);
+			ModifyLobbyMemberParams.RemovedAttributes = MoveTemp(PendingWrite.RemovedMemberAttributes);
+			
+			LobbiesInterface->ModifyLobbyMemberAttributes(MoveTemp(ModifyLobbyMemberParams)).OnComplete([OnRequestComplete](const TOnlineResult<FModifyLobbyMemberAttributes>& Result)
+			{
+				OnRequestComplete(Result.IsOk(), Result.IsError() ? &Result.GetErrorValue() : nullptr);
+			});
+		}
+	}
+}
+
+void UOnlineSampleOnlineSubsystem::HandleCreateSession(
+	const UE::Online::TOnlineResult<UE::Online::FCreateSession>& CreateSessionResult)
+{
+	using namespace UE::Online;
+
+	if(CreateSessionResult.IsOk())
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Session Creation Success"));
+	}
+	else
+	{
+		UE_LOG(LogTemp, Error, TEXT("Session Creation Failed : %s"), *CreateSessionResult.GetErrorValue().GetLogString());
+	}
+}
+
+void UOnlineSampleOnlineSubsystem::BindLobbyUpdatedEvents()
+{
+	using namespace UE::Online;
+	
+	if(ILobbiesPtr LobbiesInterface = OnlineServicesInfoInternal->LobbiesInterface)
+	{
+		LobbyMemberChangeEvent_Handles.Add(LobbiesInterface->OnLobbyMemberJoined().Add(this, &ThisClass::HandleMemberJoinedLobby));
+		LobbyMemberChangeEvent_Handles.Add(LobbiesInterface->OnLobbyMemberLeft().Add(this, &ThisClass::HandleMemberLeftLobby));
+		LobbyMemberChangeEvent_Handles.Add(LobbiesInterface->OnLobbyJoined().Add(this, &ThisClass::HandleJoinedLobby));
+		LobbyMemberChangeEvent_Handles.Add(LobbiesInterface->OnLobbyLeft().Add(this, &ThisClass::HandleLeftLobby));
+		LobbyMemberChangeEvent_Handles.Add(LobbiesInterface->OnLobbyAttributesChanged().Add(this, &ThisClass::HandleLobbyAttributeChanged));
+		LobbyMemberChangeEvent_Handles.Add(LobbiesInterface->OnLobbyMemberAttributesChanged().Add(this, &ThisClass::HandleLobbyMemberAttributeChanged));
+	}
+	else
+	{
+		UE_LOG(LogTemp, Error, TEXT("Online Services Lobbies Interface is NOT VALID"));
+	}
+}
+
+/// <summary>
+/// 로비 갱신을 알립니다.
+///		bCoalesceLobbyNotifications가 켜져 있으면 더티 표시만 하고,
+///		같은 프레임(또는 설정한 간격) 안의 알림은 FlushLobbyNotifications에서 한 번으로 합쳐집니다
+/// </summary>
+const void UOnlineSampleOnlineSubsystem::NotifyLobbyUpdated()
+{
+	bPrimaryLobbyDirty = true;
+	ScheduleLobbyNotificationFlush();
+}
+
+void UOnlineSampleOnlineSubsystem::MarkLobbyDirty(const UE::Online::FLobbyId& LobbyId)
+{
+	if(FLobbyStateEntry* Entry = LobbyStates.Find(LobbyId))
+	{
+		Entry->bDirty = true;
+	}
+	if(IsPrimaryLobby(LobbyId))
+	{
+		bPrimaryLobbyDirty = true;
+	}
+	
+	ScheduleLobbyNotificationFlush();
+}
+
+void UOnlineSampleOnlineSubsystem::ScheduleLobbyNotificationFlush()
+{
+	if(!bCoalesceLobbyNotifications)
+	{
+		FlushLobbyNotifications();
+		return;
+	}
+
+	if(bLobbyNotifyPending)
+	{
+		return;
+	}
+	bLobbyNotifyPending = true;
+
+	FTimerManager& TimerManager = GetGameInstance()->GetTimerManager();
+	if(LobbyNotifyCoalesceIntervalSeconds > 0.f)
+	{
+		TimerManager.SetTimer(LobbyNotifyTimerHandle, this, &ThisClass::FlushLobbyNotifications, LobbyNotifyCoalesceIntervalSeconds, false);
+	}
+	else
+	{
+		LobbyNotifyTimerHandle = TimerManager.SetTimerForNextTick(this, &ThisClass::FlushLobbyNotifications);
+	}
+}
+
+void UOnlineSampleOnlineSubsystem::FlushLobbyNotifications()
+{
+	UE_LOG(LogTemp, Display, TEXT("NotifyLobbyUpdated"));
+
+	bLobbyNotifyPending = false;
+	LobbyNotifyTimerHandle.Invalidate();
+
+	// 구독자가 그 자리에서 로비에 참가하거나 떠나면 Entries가 재할당되거나 자리가 바뀝니다.
+	// 그래서 알릴 로비 ID를 먼저 모으고, 하나씩 다시 찾아 정보와 델리게이트의 복사본으로 알립니다.
+	TArray<UE::Online::FLobbyId, TInlineAllocator<4>> DirtyLobbyIds;
+	for(FLobbyStateEntry& Entry : LobbyStates.Entries)
+	{
+		if(Entry.bDirty)
+		{
+			Entry.bDirty = false;
+			DirtyLobbyIds.Add(Entry.Info.Lobby->LobbyId);
+		}
+	}
+
+	for(const UE::Online::FLobbyId& LobbyId : DirtyLobbyIds)
+	{
+		const FLobbyStateEntry* Entry = LobbyStates.Find(LobbyId);
+		if(!Entry)
+		{
+			continue;
+		}
+		
+		const FBlueprintLobbyInfo LobbyInfo = Entry->Info;
+		const FLobbyInfoUpdated OnUpdated = Entry->OnUpdated;
+		OnUpdated.Broadcast(LobbyInfo);
+		OnAnyLobbyInfoUpdatedEvent.Broadcast(LobbyInfo);
+		K2_OnAnyLobbyInfoUpdatedEvent.Broadcast(LobbyInfo);
+	}
+
+	if(bPrimaryLobbyDirty)
+	{
+		bPrimaryLobbyDirty = false;
+		OnLobbyInfoUpdatedEvent.Broadcast(JoinedLobby);
+		K2_OnLobbyInfoUpdatedEvent.Broadcast(JoinedLobby);
+	}
+}
+
+UOnlineSampleOnlineSubsystem::FLobbyStateEntry& UOnlineSampleOnlineSubsystem::UpdateLobbyState(const TSharedRef<const UE::Online::FLobby>& Lobby, bool& bOutIsNewEntry)
+{
+	FLobbyStateEntry* Entry = LobbyStates.Find(Lobby->LobbyId);
+	bOutIsNewEntry = Entry == nullptr;
+	if(bOutIsNewEntry)
+	{
+		RecordFriendsPlayedWith(*Lobby, nullptr);
+		// 처음 보는 로비는 멤버 목록까지 한 번 새로 만듭니다.
+		return LobbyStates.Add(Lobby);
+	}
+	
+	RecordFriendsPlayedWith(*Lobby, &Entry->Info.Members);
+	Entry->Info.Lobby = Lobby;
+	Entry->Info.MaxMembers = Lobby->MaxMembers;
+	if(IsPrimaryLobby(Lobby->LobbyId))
+	{
+		JoinedLobby.Lobby = Lobby;
+		JoinedLobby.MaxMembers = Lobby->MaxMembers;
+	}
+	return *Entry;
+}
+
+void UOnlineSampleOnlineSubsystem::RecordFriendsPlayedWith(const UE::Online::FLobby& Lobby, const TArray<int32>* PreviousMembers)
+{
+	const FDateTime Now = FDateTime::UtcNow();
+	for(const auto& Member : Lobby.Members)
+	{
+		const int32 MemberHandle = Member.Key.GetHandle();
+		if((PreviousMembers && PreviousMembers->Contains(MemberHandle)) || FriendRoster.FindSlot(MemberHandle) == INDEX_NONE)
+		{
+			continue;
+		}
+		
+		FriendLastPlayedTimes.Add(MemberHandle, Now);
+		OnFriendLastPlayedUpdatedEvent.Broadcast(MemberHandle);
+		K2_OnFriendLastPlayedUpdatedEvent.Broadcast(MemberHandle);
+	}
+}
+
+FDateTime UOnlineSampleOnlineSubsystem::GetFriendLastPlayedTime(int32 FriendId) const
+{
+	const FDateTime* LastPlayedTime = FriendLastPlayedTimes.Find(FriendId);
+	return LastPlayedTime ? *LastPlayedTime : FDateTime();
+}
+
+void UOnlineSampleOnlineSubsystem::SetPrimaryLobby(const FLobbyStateEntry& Entry)
+{
+	JoinedLobby = Entry.Info;
+	bPrimaryLobbyDirty = true;
+}
+
+bool UOnlineSampleOnlineSubsystem::IsPrimaryLobby(const UE::Online::FLobbyId& LobbyId) const
+{
+	return JoinedLobby.Lobby.IsValid() && JoinedLobby.Lobby->LobbyId == LobbyId;
+}
+
+TArray<FBlueprintLobbyInfo> UOnlineSampleOnlineSubsystem::GetJoinedLobbies() const
+{
+	TArray<FBlueprintLobbyInfo> Lobbies;
+	Lobbies.Reserve(LobbyStates.Entries.Num());
+	for(const FLobbyStateEntry& Entry : LobbyStates.Entries)
+	{
+		Lobbies.Add(Entry.Info);
+	}
+	return Lobbies;
+}
+
+FDelegateHandle UOnlineSampleOnlineSubsystem::AddLobbyUpdatedHandler(const UE::Online::FLobbyId& LobbyId, FLobbyInfoUpdated::FDelegate&& Delegate)
+{
+	if(FLobbyStateEntry* Entry = LobbyStates.Find(LobbyId))
+	{
+		return Entry->OnUpdated.Add(MoveTemp(Delegate));
+	}
+	return FDelegateHandle();
+}
+
+bool UOnlineSampleOnlineSubsystem::RemoveLobbyUpdatedHandler(const UE::Online::FLobbyId& LobbyId, FDelegateHandle Handle)
+{
+	if(FLobbyStateEntry* Entry = LobbyStates.Find(LobbyId))
+	{
+		return Entry->OnUpdated.Remove(Handle);
+	}
+	return false;
+}
+
+void UOnlineSampleOnlineSubsystem::HandleMemberJoinedLobby(const UE::Online::FLobbyMemberJoined& Info)
+{
+	UE_LOG(LogTemp, Display, TEXT("HandleMemberJoinedLobby"));
+
+	FBlueprintLobbyMemberDelta MemberDelta;
+	MemberDelta.LobbyId = Info.Lobby->LobbyId.GetHandle();
+	MemberDelta.MemberId = Info.Member->AccountId.GetHandle();
+	MemberDelta.bIsLocalMember = Info.Member->bIsLocalMember;
+
+	bool bIsNewEntry = false;
+	FLobbyStateEntry& Entry = UpdateLobbyState(Info.Lobby, bIsNewEntry);
+	if(!bIsNewEntry)
+	{
+		Entry.Info.Members.AddUnique(MemberDelta.MemberId);
+		if(IsPrimaryLobby(Info.Lobby->LobbyId))
+		{
+			JoinedLobby.Members.AddUnique(MemberDelta.MemberId);
+		}
+	}
+
+	OnLobbyMemberAddedEvent.Broadcast(MemberDelta);
+	K2_OnLobbyMemberAddedEvent.Broadcast(MemberDelta);
+	
+	MarkLobbyDirty(Info.Lobby->LobbyId);
+}
+
+void UOnlineSampleOnlineSubsystem::HandleMemberLeftLobby(const UE::Online::FLobbyMemberLeft& Info)
+{
+	UE_LOG(LogTemp, Display, TEXT("HandleMemberLeftLobby"));
+
+	FBlueprintLobbyMemberDelta MemberDelta;
+	MemberDelta.LobbyId = Info.Lobby->LobbyId.GetHandle();
+	MemberDelta.MemberId = Info.Member->AccountId.GetHandle();
+	MemberDelta.bIsLocalMember = Info.Member->bIsLocalMember;
+
+	bool bIsNewEntry = false;
+	FLobbyStateEntry& Entry = UpdateLobbyState(Info.Lobby, bIsNewEntry);
+	if(!bIsNewEntry)
+	{
+		Entry.Info.Members.Remove(MemberDelta.MemberId);
+		if(IsPrimaryLobby(Info.Lobby->LobbyId))
+		{
+			JoinedLobby.Members.Remove(MemberDelta.MemberId);
+		}
+	}
+
+	OnLobbyMemberRemovedEvent.Broadcast(MemberDelta);
+	K2_OnLobbyMemberRemovedEvent.Broadcast(MemberDelta);
+	
+	MarkLobbyDirty(Info.Lobby->LobbyId);
+}
+
+void UOnlineSampleOnlineSubsystem::HandleJoinedLobby(const UE::Online::FLobbyJoined& Info)
+{
+	using namespace UE::Online;
+	
+	UE_LOG(LogTemp, Display, TEXT("Handle Joined Lobby"));
+
+	bool bIsNewEntry = false;
+	FLobbyStateEntry& Entry = UpdateLobbyState(Info.Lobby, bIsNewEntry);
+	if(!bIsNewEntry)
+	{
+		// 참가 시점의 스냅샷이 기준이므로 멤버 목록을 새로 맞춥니다.
+		Entry.Info = FBlueprintLobbyInfo(Info.Lobby);
+	}
+
+	// 다른 로비(예: 파티 로비)가 이미 JoinedLobby라면 덮어쓰지 않습니다.
+	if(JoinedLobby.Lobby.IsValid() && !IsPrimaryLobby(Info.Lobby->LobbyId))
+	{
+		MarkLobbyDirty(Info.Lobby->LobbyId);
+		return;
+	}
+	SetPrimaryLobby(Entry);
+	
+	// 참가 요청을 보낸 계정, 없으면 로비를 만든 로컬 계정을 씁니다.
+	const FLobby& Lobby = Info.Lobby.Get();
+	FAccountId LocalPlayerAccountId = PendingLobbyJoins.FindRef(Lobby.LobbyId);
+	if(!LocalPlayerAccountId.IsValid() && FindLocalPlayerByAccountId(Lobby.OwnerAccountId))
+	{
+		LocalPlayerAccountId = Lobby.OwnerAccountId;
+	}
+	else if(!LocalPlayerAccountId.IsValid())
+	{
+		if(ULocalPlayer* MemberPlayer = FindLocalPlayerInLobby(Lobby))
+		{
+			LocalPlayerAccountId = GetOnlineUserInfo(MemberPlayer->GetPlatformUserId())->AccountId;
+		}
+	}
+	if(const TSharedRef<const FLobbyMember>* LobbyMember = Lobby.Members.Find(LocalPlayerAccountId))
+	{
+		LocalPlayerLobbyMemberInfo = FBlueprintLobbyMemberInfo(LobbyMember->Get(), Lobby.OwnerAccountId == LocalPlayerAccountId);
+	}
+	
+	MarkLobbyDirty(Info.Lobby->LobbyId);
+}
+
+void UOnlineSampleOnlineSubsystem::HandleLeftLobby(const UE::Online::FLobbyLeft& Info)
+{
+	UE_LOG(LogTemp, Display, TEXT("Handle Left Lobby"));
+
+	const UE::Online::FLobbyId LeftLobbyId = Info.Lobby->LobbyId;
+	if(FLobbyStateEntry* Entry = LobbyStates.Find(LeftLobbyId))
+	{
+		// 이 로비만 구독하던 쪽에는 빈 정보로 마지막 알림을 보냅니다.
+		Entry->OnUpdated.Broadcast(FBlueprintLobbyInfo());
+		LobbyStates.Remove(LeftLobbyId);
+	}
+	
+	if(CreatedLobby.IsValid() && CreatedLobby->LobbyId == LeftLobbyId)
+	{
+		CreatedLobby = nullptr;
+		StopQosResponder();
+	}
+	
+	if(IsPrimaryLobby(LeftLobbyId))
+	{
+		JoinedLobby = FBlueprintLobbyInfo();
+		LocalPlayerLobbyMemberInfo = FBlueprintLobbyMemberInfo();
+		NotifyLobbyUpdated();
+	}
+}
+
+void UOnlineSampleOnlineSubsystem::HandleLobbyAttributeChanged(const UE::Online::FLobbyAttributesChanged& Info)
+{
+	using namespace UE::Online;
+	
+	UE_LOG(LogTemp, Display, TEXT("Handle Lobby Attributes Change"));
+
+	// // 로비에서 게임이 시작되는 경우.
+	// if(Info.ChangedAttributes.Contains(FName(TEXT("MATCHSTATE"))))
+	// {
+	// 	FString PrevMatchState = Info.ChangedAttributes.Find(FName(TEXT("MATCHSTATE")))->Key.GetString();
+	// 	FString PostMatchState = Info.ChangedAttributes.Find(FName(TEXT("MATCHSTATE")))->Value.GetString();
+	//
+	// 	if(PrevMatchState.Equals(FString(TEXT("Waiting")))  && PostMatchState.Equals(FString(TEXT("Starting")))
+	// 		&& !LocalPlayerLobbyMemberInfo.bIsLobbyOwner)
+	// 	{
+	// 		TravelToLobby(GetWorld()->GetFirstLocalPlayerFromController(), JoinedLobby);
+	// 	}else
+	// 	{
+	// 		if(!PrevMatchState.Equals(FString(TEXT("Waiting"))))
 	// 		{
 	// 			UE_LOG(LogTemp, Warning, TEXT("Testing Something. Erase This LOG Later1"));
 	// 		}
@@ -403,319 +1148,1925 @@ void UOnlineSampleOnlineSubsystem::HandleLobbyAttributeChanged(const UE::Online:
 	// 	}
 	// }
 	
+	bool bIsNewEntry = false;
+	UpdateLobbyState(Info.Lobby, bIsNewEntry);
+
+	FBlueprintLobbyAttributeDelta AttributeDelta;
+	AttributeDelta.LobbyId = Info.Lobby->LobbyId.GetHandle();
+	AttributeDelta.ChangedAttributes.Reserve(Info.AddedAttributes.Num() + Info.ChangedAttributes.Num());
+	for(auto& Tuple : Info.AddedAttributes)
+	{
+		AttributeDelta.ChangedAttributes.Add(Tuple.Key, FOnlineSampleLobbySchema::VariantToString(Tuple.Value));
+	}
 	for(auto& Tuple : Info.ChangedAttributes)
 	{
-		UE_LOG(LogTemp, Display, TEXT("Changed Attribute - %s , %s"), *Tuple.Value.Key.ToLogString(), *Tuple.Value.Value.ToLogString());
+		UE_LOG(LogTemp, Display, TEXT("Changed Attribute - %s , %s"), *Tuple.Value.Key.ToLogString(), *Tuple.Value.Value.ToLogString());
+		AttributeDelta.ChangedAttributes.Add(Tuple.Key, FOnlineSampleLobbySchema::VariantToString(Tuple.Value.Value));
+	}
+	AttributeDelta.RemovedAttributes = Info.RemovedAttributes.Array();
+
+	OnLobbyAttributesChangedEvent.Broadcast(AttributeDelta);
+	K2_OnLobbyAttributesChangedEvent.Broadcast(AttributeDelta);
+	//
+	MarkLobbyDirty(Info.Lobby->LobbyId);
+}
+
+void UOnlineSampleOnlineSubsystem::HandleLobbyMemberAttributeChanged(const UE::Online::FLobbyMemberAttributesChanged& Info)
+{
+	using namespace UE::Online;
+	
+	bool bIsNewEntry = false;
+	UpdateLobbyState(Info.Lobby, bIsNewEntry);
+
+	FBlueprintLobbyAttributeDelta AttributeDelta;
+	AttributeDelta.LobbyId = Info.Lobby->LobbyId.GetHandle();
+	AttributeDelta.MemberId = Info.Member->AccountId.GetHandle();
+	AttributeDelta.ChangedAttributes.Reserve(Info.AddedAttributes.Num() + Info.ChangedAttributes.Num());
+	for(auto& Tuple : Info.AddedAttributes)
+	{
+		AttributeDelta.ChangedAttributes.Add(Tuple.Key, FOnlineSampleLobbySchema::VariantToString(Tuple.Value));
+	}
+	for(auto& Tuple : Info.ChangedAttributes)
+	{
+		AttributeDelta.ChangedAttributes.Add(Tuple.Key, FOnlineSampleLobbySchema::VariantToString(Tuple.Value.Value));
+	}
+	AttributeDelta.RemovedAttributes = Info.RemovedAttributes.Array();
+
+	OnLobbyAttributesChangedEvent.Broadcast(AttributeDelta);
+	K2_OnLobbyAttributesChangedEvent.Broadcast(AttributeDelta);
+}
+
+
+/// <summary>
+/// 온라인 서비스를 초기화합니다.
+///		서비스에 대한 포인터를 가져옵니다
+///		인터페이스에 대한 포인터를 가져옵니다
+///		이벤트 핸들을 추가합니다
+///		포인터 유효성을 확인합니다
+/// </summary>
+void UOnlineSampleOnlineSubsystem::InitializeOnlineServices()
+{
+	OnlineServicesInfoInternal = new FOnlineServicesInfo();
+ 
+	// 서비스 포인터를 초기화합니다
+	OnlineServicesInfoInternal->OnlineServices = UE::Online::GetServices();
+	check(OnlineServicesInfoInternal->OnlineServices.IsValid());
+ 
+	// 서비스 타입을 검증합니다
+	OnlineServicesInfoInternal->OnlineServicesType = OnlineServicesInfoInternal->OnlineServices->GetServicesProvider();
+	if (OnlineServicesInfoInternal->OnlineServices.IsValid())
+	{
+		// 인터페이스 포인터를 초기화합니다
+		OnlineServicesInfoInternal->AuthInterface = OnlineServicesInfoInternal->OnlineServices->GetAuthInterface();
+		check(OnlineServicesInfoInternal->AuthInterface.IsValid());
+ 
+		OnlineServicesInfoInternal->TitleFileInterface = OnlineServicesInfoInternal->OnlineServices->GetTitleFileInterface();
+		check(OnlineServicesInfoInternal->TitleFileInterface.IsValid());
+
+		//자 이번엔 내가 따라서 세션 인터페이스를 추가해보자.
+		OnlineServicesInfoInternal->SessionsInterface = OnlineServicesInfoInternal->OnlineServices->GetSessionsInterface();
+		check(OnlineServicesInfoInternal->SessionsInterface.IsValid());
+
+		OnlineServicesInfoInternal->LobbiesInterface = OnlineServicesInfoInternal->OnlineServices->GetLobbiesInterface();
+		check(OnlineServicesInfoInternal->LobbiesInterface.IsValid());
+
+		OnlineServicesInfoInternal->SocialInterface = OnlineServicesInfoInternal->OnlineServices->GetSocialInterface();
+		check(OnlineServicesInfoInternal->SocialInterface.IsValid());
+
+		OnlineServicesInfoInternal->UserInfoInterface = OnlineServicesInfoInternal->OnlineServices->GetUserInfoInterface();
+		check(OnlineServicesInfoInternal->UserInfoInterface.IsValid());
+
+		OnlineServicesInfoInternal->PresenceInterface = OnlineServicesInfoInternal->OnlineServices->GetPresenceInterface();
+		check(OnlineServicesInfoInternal->PresenceInterface.IsValid());
+		
+		
+	}
+	else {
+		UE_LOG(LogOnlineSampleOnlineSubsystem, Error, TEXT("Error: Failed to initialize services."));
+	}
+}
+ 
+
+/// <summary>
+/// 로컬 레지스트리 OnlineUserInfos에 온라인 사용자를 등록합니다
+/// </summary>
+/// <param name="PlatformUserId">등록할 사용자의 플랫폼 사용자 ID입니다</param>
+void UOnlineSampleOnlineSubsystem::RegisterLocalOnlineUser(FPlatformUserId PlatformUserId)
+{
+	using namespace UE::Online;
+ 
+	FAuthGetLocalOnlineUserByPlatformUserId::Params GetUserParams;
+	//GetUserParams.
+	GetUserParams.PlatformUserId = PlatformUserId;
+	if (OnlineServicesInfoInternal->AuthInterface.IsValid())
+	{
+		TOnlineResult<FAuthGetLocalOnlineUserByPlatformUserId> AuthGetResult = OnlineServicesInfoInternal->AuthInterface->GetLocalOnlineUserByPlatformUserId(MoveTemp(GetUserParams));
+ 
+		if (AuthGetResult.IsOk())
+		{
+			FAuthGetLocalOnlineUserByPlatformUserId::Result& LocalOnlineUser = AuthGetResult.GetOkValue();
+			TSharedRef<FAccountInfo> UserAccountInfo = LocalOnlineUser.AccountInfo;
+			FAccountInfo UserAccountInfoContent = *UserAccountInfo;
+			if (!OnlineUserInfos.Contains(UserAccountInfoContent.PlatformUserId))
+			{
+				UOnlineUserInfo* NewUser = CreateAndRegisterUserInfo(GetLocalUserIndex(PlatformUserId), PlatformUserId, UserAccountInfoContent.AccountId, UserAccountInfoContent.AccountId.GetOnlineServicesType());
+ 
+				UE_LOG(LogOnlineSampleOnlineSubsystem, Log, TEXT("Local User Registered: %s"), *(NewUser->DebugInfoToString()));
+			}
+			else
+			{
+				UE_LOG(LogOnlineSampleOnlineSubsystem, Log, TEXT("Local User with platform user id %d already registered."), PlatformUserId.GetInternalId());
+			}
+		}
+		else
+		{
+			FOnlineError ErrorResult = AuthGetResult.GetErrorValue();
+			UE_LOG(LogOnlineSampleOnlineSubsystem, Error, TEXT("Get Local Online User Error: %s"), *ErrorResult.GetLogString());
+		}
+	}
+	else
+	{
+		UE_LOG(LogOnlineSampleOnlineSubsystem, Error, TEXT("Auth Interface pointer invalid."));
+	}
+}
+
+void UOnlineSampleOnlineSubsystem::K2_CreateSession(int32 MaxPlayer, bool IsLan, FPlatformUserId PlatformUserId)
+{
+
+	
+	UE::Online::FCreateSession::Params SessionParams;
+	SessionParams.bPresenceEnabled = true;
+	SessionParams.bIsLANSession = IsLan;
+	SessionParams.SessionSettings.NumMaxConnections = MaxPlayer;
+	SessionParams.SessionSettings.SchemaName = TEXT("GameSession");
+	SessionParams.SessionName = TEXT("MySessionName");
+	//SessionParams.LocalAccountId = 
+	//SessionParams.LocalAccountId = 0;
+
+	CreateSession(SessionParams, PlatformUserId);
+}
+
+void UOnlineSampleOnlineSubsystem::CreateSession(UE::Online::FCreateSession::Params SessionParams, FPlatformUserId PlatformUserId)
+{
+	using namespace UE::Online;
+
+	ISessionsPtr SessionInterface = OnlineServicesInfoInternal->SessionsInterface;
+
+	 if(OnlineUserInfos.Contains(PlatformUserId))
+	 {
+
+		TObjectPtr<const UOnlineUserInfo> OnlineUser = *OnlineUserInfos.Find(PlatformUserId);
+		FAccountId LocalAccountId = OnlineUser->AccountId;
+		SessionParams.LocalAccountId = LocalAccountId;
+		
+		if(SessionInterface.IsValid())
+		{
+			// LAN 세션은 백엔드 없이도 찾을 수 있게, 만드는 데 성공하면 비컨을 켭니다.
+			const bool bIsLanSession = SessionParams.bIsLANSession;
+			const int32 MaxPlayers = SessionParams.SessionSettings.NumMaxConnections;
+			SessionInterface->CreateSession(MoveTemp(SessionParams)).OnComplete([this, bIsLanSession, MaxPlayers](const TOnlineResult<FCreateSession>& CreateSessionResult)
+			{
+				HandleCreateSession(CreateSessionResult);
+				if(CreateSessionResult.IsOk() && bIsLanSession)
+				{
+					StartLanBeacon(MaxPlayers);
+				}
+			});
+		}
+		else
+		{
+			UE_LOG(LogOnlineSampleOnlineSubsystem, Error, TEXT("Sessions Interface pointer invalid."));
+		}
+	 }else
+	 {
+	 	UE_LOG(LogOnlineSampleOnlineSubsystem, Error, TEXT("Could not find user with Platform User Id: %d"), PlatformUserId.GetInternalId());
+	 }
+}
+
+void UOnlineSampleOnlineSubsystem::FindSessions(UE::Online::FFindSessions::Params SessionFindParams)
+{
+	using namespace UE::Online;
+
+	ISessionsPtr SessionInterface = OnlineServicesInfoInternal->SessionsInterface;
+
+	if(SessionInterface.IsValid())
+	{
+		
+		UE_LOG(LogTemp, Warning, TEXT("Start FindSessions With Parameter - MaxResults : %d, LocalAccountId : %d"),
+			SessionFindParams.MaxResults, SessionFindParams.LocalAccountId.GetHandle());
+		
+		
+		// 이전 검색의 남은 작업과 응답은 버립니다.
+		if(LanBeaconClient)
+		{
+			LanBeaconClient->Cancel();
+		}
+		GetGameInstance()->GetTimerManager().ClearTimer(SessionSearchState.TimerHandle);
+		SessionSearchState.PendingSessionIds.Reset();
+		SessionSearchState.NextIndex = 0;
+		SessionSearchState.bActive = true;
+		++SessionSearchState.Serial;
+		
+		SessionInterface->FindSessions(MoveTemp(SessionFindParams)).OnComplete([this, Serial = SessionSearchState.Serial](const UE::Online::TOnlineResult<FFindSessions> &FindSessionsResult)
+		{
+			if(!SessionSearchState.bActive || SessionSearchState.Serial != Serial)
+			{
+				return;
+			}
+			
+			if(FindSessionsResult.IsOk())
+			{
+				FoundSessions.Reset(FindSessionsResult.GetOkValue().FoundSessionIds.Num());
+				SessionSearchState.PendingSessionIds = FindSessionsResult.GetOkValue().FoundSessionIds;
+				BuildFoundSessionSummaries();
+			}
+			else
+			{
+				UE_LOG(LogTemp, Error, TEXT("Find Sessions Failed : %s"), *FindSessionsResult.GetErrorValue().GetLogString())	
+				FinishFindSessions(false);
+			}
+		});
+	}
+	else
+	{
+		FinishFindSessions(false);
+	}
+}
+
+void UOnlineSampleOnlineSubsystem::FindLanSessions(int32 MaxResults)
+{
+	if(!LanBeaconClient)
+	{
+		LanBeaconClient = MakeUnique<FOnlineSampleLanBeaconClient>();
+	}
+
+	// 진행 중인 온라인 검색은 버립니다.
+	GetGameInstance()->GetTimerManager().ClearTimer(SessionSearchState.TimerHandle);
+	SessionSearchState.PendingSessionIds.Reset();
+	SessionSearchState.NextIndex = 0;
+	SessionSearchState.bActive = true;
+	++SessionSearchState.Serial;
+	FoundSessions.Reset();
+
+	const bool bStarted = LanBeaconClient->Start(LanBeaconPort, LanDiscoveryTimeoutSeconds, bLanDiscoveryIncludeLoopback,
+		[this, MaxResults](const FString& HostAddress, const FOnlineSampleLanHostInfo& HostInfo)
+		{
+			if(MaxResults > 0 && FoundSessions.Num() >= MaxResults)
+			{
+				return;
+			}
+			
+			FBlueprintSessionInfo& SessionInfo = FoundSessions.AddDefaulted_GetRef();
+			SessionInfo.bIsLan = true;
+			SessionInfo.HostAddress = HostAddress;
+			SessionInfo.SessionInfoString = HostInfo.HostName;
+			SessionInfo.MaxPlayers = HostInfo.MaxPlayers;
+			SessionInfo.NumPlayers = HostInfo.NumPlayers;
+			SessionInfo.NumOpenSlots = FMath::Max(HostInfo.MaxPlayers - HostInfo.NumPlayers, 0);
+			SessionInfo.bIsJoinable = SessionInfo.NumOpenSlots > 0;
+			for(const TPair<FString, FString>& Attribute : HostInfo.Attributes)
+			{
+				SessionInfo.Attributes.Add(FName(*Attribute.Key), Attribute.Value);
+			}
+		},
+		[this, Serial = SessionSearchState.Serial]()
+		{
+			if(SessionSearchState.bActive && SessionSearchState.Serial == Serial)
+			{
+				FinishFindSessions(true);
+			}
+		});
+
+	if(!bStarted)
+	{
+		UE_LOG(LogOnlineSampleOnlineSubsystem, Error, TEXT("Failed to send LAN discovery query"));
+		FinishFindSessions(false);
+	}
+}
+
+bool UOnlineSampleOnlineSubsystem::StartLanBeacon(int32 MaxPlayers)
+{
+	LanBeaconMaxPlayers = MaxPlayers;
+	
+	if(!LanBeaconHost)
+	{
+		LanBeaconHost = MakeUnique<FOnlineSampleLanBeaconHost>();
+	}
+	if(LanBeaconHost->IsRunning())
+	{
+		return true;
+	}
+
+	if(!LanBeaconHost->Start(LanBeaconPort, [this](FOnlineSampleLanHostInfo& OutHostInfo) { return MakeLanHostInfo(OutHostInfo); }))
+	{
+		UE_LOG(LogOnlineSampleOnlineSubsystem, Error, TEXT("Failed to start LAN beacon on port %d"), LanBeaconPort);
+		return false;
+	}
+
+	UE_LOG(LogOnlineSampleOnlineSubsystem, Log, TEXT("LAN beacon listening on port %d"), LanBeaconPort);
+	return true;
+}
+
+void UOnlineSampleOnlineSubsystem::StopLanBeacon()
+{
+	LanBeaconHost.Reset();
+}
+
+bool UOnlineSampleOnlineSubsystem::MakeLanHostInfo(FOnlineSampleLanHostInfo& OutHostInfo) const
+{
+	// 리슨 서버로 맵을 옮기기 전에는 접속을 받을 포트가 없으므로 답하지 않습니다.
+	const UWorld* World = GetWorld();
+	const UNetDriver* NetDriver = World ? World->GetNetDriver() : nullptr;
+	if(!NetDriver || World->GetNetMode() != NM_ListenServer || !NetDriver->GetLocalAddr().IsValid())
+	{
+		return false;
+	}
+
+	OutHostInfo.HostName = FPlatformProcess::ComputerName();
+	OutHostInfo.GamePort = NetDriver->GetLocalAddr()->GetPort();
+	OutHostInfo.MaxPlayers = LanBeaconMaxPlayers;
+	OutHostInfo.NumPlayers = 1;
+	OutHostInfo.Attributes.Add(TEXT("MAPNAME"), World->GetMapName());
+	if(const AGameStateBase* GameState = World->GetGameState())
+	{
+		OutHostInfo.NumPlayers = FMath::Max(GameState->PlayerArray.Num(), 1);
+	}
+	return true;
+}
+
+void UOnlineSampleOnlineSubsystem::K2_JoinLanSession(APlayerController* PlayerController, const FBlueprintSessionInfo& SessionInfo)
+{
+	check(PlayerController);
+
+	if(!SessionInfo.bIsLan || SessionInfo.HostAddress.IsEmpty())
+	{
+		UE_LOG(LogOnlineSampleOnlineSubsystem, Warning, TEXT("Session has no LAN host address"));
+		return;
+	}
+	PlayerController->ClientTravel(SessionInfo.HostAddress, TRAVEL_Absolute);
+}
+
+void UOnlineSampleOnlineSubsystem::BuildFoundSessionSummaries()
+{
+	using namespace UE::Online;
+
+	ISessionsPtr SessionInterface = OnlineServicesInfoInternal->SessionsInterface;
+	if(!SessionSearchState.bActive || !SessionInterface.IsValid())
+	{
+		FinishFindSessions(false);
+		return;
+	}
+
+	const TArray<FOnlineSessionId>& SessionIds = SessionSearchState.PendingSessionIds;
+	const int32 LastIndex = FMath::Min(SessionSearchState.NextIndex + FMath::Max(SessionSummariesPerFrame, 1), SessionIds.Num());
+	for(; SessionSearchState.NextIndex < LastIndex; ++SessionSearchState.NextIndex)
+	{
+		FGetSessionById::Params GetSessionParams;
+		GetSessionParams.SessionId = SessionIds[SessionSearchState.NextIndex];
+		TOnlineResult<FGetSessionById> GetSessionByIdResult = SessionInterface->GetSessionById(MoveTemp(GetSessionParams));
+		if(GetSessionByIdResult.IsOk())
+		{
+			FoundSessions.Emplace(*GetSessionByIdResult.GetOkValue().Session);
+		}
+		else
+		{
+			UE_LOG(LogOnlineSampleOnlineSubsystem, Verbose, TEXT("Found session vanished before summary : %s"), *GetSessionByIdResult.GetErrorValue().GetLogString());
+		}
+	}
+
+	if(SessionSearchState.NextIndex < SessionIds.Num())
+	{
+		SessionSearchState.TimerHandle = GetGameInstance()->GetTimerManager().SetTimerForNextTick(this, &ThisClass::BuildFoundSessionSummaries);
+		return;
+	}
+	FinishFindSessions(true);
+}
+
+void UOnlineSampleOnlineSubsystem::FinishFindSessions(bool bSucceeded)
+{
+	SessionSearchState.bActive = false;
+	SessionSearchState.PendingSessionIds.Empty();
+	SessionSearchState.NextIndex = 0;
+	
+	UE_LOG(LogOnlineSampleOnlineSubsystem, Log, TEXT("Find Sessions Complete : %d Sessions"), FoundSessions.Num());
+	OnFindSessionsCompleteEvent.Broadcast(bSucceeded, FoundSessions.Num());
+	K2_OnFindSessionsCompleteEvent.Broadcast(bSucceeded, FoundSessions.Num());
+}
+
+void UOnlineSampleOnlineSubsystem::K2_CreateLobby(ULocalPlayer* LocalPlayer, const FCreateLobbyRequest& Request)
+{
+	//
+	check(!Request.LevelToTravel.IsNull());//
+	
+	CreateLobby(LocalPlayer, Request);
+}
+
+void UOnlineSampleOnlineSubsystem::CreateLobby(ULocalPlayer* LocalPlayer,const FCreateLobbyRequest& Request)
+{
+	using namespace UE::Online;
+	
+	if(!IsLoggedIn(LocalPlayer))
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Create Lobby Failed : Not Logged In"));
+		OnCreateLobbyCompleteEvent.Broadcast(false);
+		K2_OnCreateLobbyCompleteEvent.Broadcast(false);
+		return;
+	}
+	
+	
+	if(UE::Online::ILobbiesPtr LobbiesInterface = OnlineServicesInfoInternal->LobbiesInterface)
+	{
+		UE::Online::FCreateLobby::Params CreateLobbyParams;
+		if(PrepareCreateLobbyParams(LocalPlayer, Request, CreateLobbyParams))
+		{
+			LobbiesInterface->CreateLobby(MoveTemp(CreateLobbyParams)).OnComplete(this, &ThisClass::HandleCreateLobby);
+			return;
+		}
+		
+		OnCreateLobbyCompleteEvent.Broadcast(false);
+		K2_OnCreateLobbyCompleteEvent.Broadcast(false);
+	}
+	else
+	{
+		OnCreateLobbyCompleteEvent.Broadcast(false);
+		K2_OnCreateLobbyCompleteEvent.Broadcast(false);
+	}
+}
+
+bool UOnlineSampleOnlineSubsystem::PrepareCreateLobbyParams(ULocalPlayer* LocalPlayer, const FCreateLobbyRequest& Request, UE::Online::FCreateLobby::Params& CreateLobbyParams)
+{
+	using namespace UE::Online;
+
+	// 백엔드가 조용히 거절하지 않도록 QoS 응답자나 미리 읽기를 켜기 전에 MAPNAME부터 확인합니다.
+	FString MapName;
+	if(!MakeLobbyMapName(Request.LevelToTravel, MapName))
+	{
+		return false;
+	}
+	
+	//const FName SessionName(NAME_GameSession); // 일단 일반 사용자 플러그인에서 긁어온거. 흠..
+	
+	CreateLobbyParams.SchemaId = FSchemaId(TEXT("GameLobby"));
+	CreateLobbyParams.LocalAccountId = GetOnlineUserInfo(LocalPlayer->GetPlatformUserId())->AccountId;
+	//CreateLobbyParams.LocalName = SessionName;
+	CreateLobbyParams.LocalName = Request.LobbyName;//
+	CreateLobbyParams.bPresenceEnabled = true;
+	CreateLobbyParams.JoinPolicy = UE::Online::ELobbyJoinPolicy::PublicAdvertised;
+	CreateLobbyParams.Attributes.Emplace(FName(TEXT("GAMEMODE")), FString(TEXT("GAMEMODE1")));
+	// 클라이언트가 미리 읽을 수 있도록 이동할 레벨의 패키지 이름이나 별칭을 알립니다.
+	CreateLobbyParams.Attributes.Emplace(FName(TEXT("MAPNAME")), MoveTemp(MapName));
+	//CreateLobbyParams.Attributes.Emplace(FName(TEXT("MATCHTIMEOUT")), 120.0f);
+	//CreateLobbyParams.Attributes.Emplace(FName(TEXT("SESSIONTEMPLATENAME")), FString(TEXT("GameSession")));
+	//CreateLobbyParams.Attributes.Emplace(FName(TEXT("OSSv2")), true);
+	CreateLobbyParams.Attributes.Emplace(FName(TEXT("PRESENCESEARCH")), true);
+	CreateLobbyParams.Attributes.Emplace(FName(TEXT("GAMEMODE")), FString(TEXT("GameSession")));
+	CreateLobbyParams.Attributes.Emplace(FName(TEXT("MATCHSTATE")), FString(TEXT("Waiting")));
+	// 클라이언트가 RTT를 잴 수 있도록 QoS 응답자 주소를 알립니다.
+	if(bEnableLobbyQos && StartQosResponder())
+	{
+		CreateLobbyParams.Attributes.Emplace(FName(TEXT("QOSADDR")), QosResponder->GetHostAddressString());
+	}
+	
+	CreateLobbyParams.MaxMembers = Request.MaxPlayers;
+
+	// 게임을 시작할 때 디스크를 기다리지 않도록 이동할 레벨을 지금부터 읽어둡니다.
+	HostLevelToTravel = Request.LevelToTravel;
+	if(HostMapPreloadHandle.IsValid())
+	{
+		HostMapPreloadHandle->CancelHandle();
+		HostMapPreloadHandle.Reset();
+	}
+	if(!HostLevelToTravel.IsNull())
+	{
+		HostMapPreloadHandle = UAssetManager::GetStreamableManager().RequestAsyncLoad(HostLevelToTravel.ToSoftObjectPath(), FStreamableDelegate(), FStreamableManager::AsyncLoadHighPriority);
+	}
+
+	//유저 아트리뷰트
+	CreateLobbyParams.UserAttributes.Emplace(FName(TEXT("GAMEMODE")), FString(TEXT("GameSession")));
+	CreateLobbyParams.UserAttributes.Emplace(FName(TEXT("MATCHSTATE")), FString(TEXT("Waiting")));
+	return true;
+}
+
+void UOnlineSampleOnlineSubsystem::CreateLobbyAndSession(ULocalPlayer* LocalPlayer, const FCreateLobbyRequest& Request, bool bIsLanSession)
+{
+	using namespace UE::Online;
+	check(LocalPlayer);
+
+	ILobbiesPtr LobbiesInterface = OnlineServicesInfoInternal->LobbiesInterface;
+	ISessionsPtr SessionsInterface = OnlineServicesInfoInternal->SessionsInterface;
+	const TCHAR* FailReason = HostSetupState.bActive ? TEXT("Already In Progress")
+		: !IsLoggedIn(LocalPlayer) ? TEXT("Not Logged In")
+		: !LobbiesInterface ? TEXT("Lobbies Interface Unavailable")
+		: !SessionsInterface ? TEXT("Sessions Interface Unavailable")
+		: nullptr;
+	if(FailReason)
+	{
+		UE_LOG(LogOnlineSampleOnlineSubsystem, Warning, TEXT("Create Lobby And Session Failed : %s"), FailReason);
+		OnCreateLobbyAndSessionCompleteEvent.Broadcast(false, FBlueprintLobbyInfo(), FBlueprintSessionInfo());
+		K2_OnCreateLobbyAndSessionCompleteEvent.Broadcast(false, FBlueprintLobbyInfo(), FBlueprintSessionInfo());
+		return;
+	}
+
+	FCreateLobby::Params CreateLobbyParams;
+	if(!PrepareCreateLobbyParams(LocalPlayer, Request, CreateLobbyParams))
+	{
+		OnCreateLobbyAndSessionCompleteEvent.Broadcast(false, FBlueprintLobbyInfo(), FBlueprintSessionInfo());
+		K2_OnCreateLobbyAndSessionCompleteEvent.Broadcast(false, FBlueprintLobbyInfo(), FBlueprintSessionInfo());
+		return;
+	}
+
+	HostSetupState.LocalPlayer = LocalPlayer;
+	HostSetupState.LocalAccountId = GetOnlineUserInfo(LocalPlayer->GetPlatformUserId())->AccountId;
+	HostSetupState.LinkId = FGuid::NewGuid().ToString(EGuidFormats::Digits);
+	HostSetupState.SessionName = NAME_GameSession;
+	HostSetupState.LobbyResult.Reset();
+	HostSetupState.SessionResult.Reset();
+	HostSetupState.bIsLanSession = bIsLanSession;
+	HostSetupState.MaxPlayers = Request.MaxPlayers;
+	HostSetupState.bActive = true;
+	const uint32 Serial = ++HostSetupState.Serial;
+
+	// 서로의 ID를 기다리지 않도록 둘 다 미리 만든 LINKID를 들고 동시에 보냅니다.
+	CreateLobbyParams.Attributes.Emplace(FName(TEXT("LINKID")), HostSetupState.LinkId);
+
+	FCreateSession::Params SessionParams;
+	SessionParams.LocalAccountId = CreateLobbyParams.LocalAccountId;
+	SessionParams.SessionName = HostSetupState.SessionName;
+	SessionParams.bPresenceEnabled = false;
+	SessionParams.bIsLANSession = bIsLanSession;
+	SessionParams.SessionSettings.SchemaName = TEXT("GameSession");
+	SessionParams.SessionSettings.NumMaxConnections = Request.MaxPlayers;
+	FCustomSessionSetting LinkSetting;
+	LinkSetting.Data = FSchemaVariant(HostSetupState.LinkId);
+	LinkSetting.Visibility = ESchemaAttributeVisibility::Public;
+	SessionParams.SessionSettings.CustomSettings.Emplace(FName(TEXT("LINKID")), MoveTemp(LinkSetting));
+
+	LobbiesInterface->CreateLobby(MoveTemp(CreateLobbyParams)).OnComplete([this, Serial](const TOnlineResult<FCreateLobby>& CreateLobbyResult)
+	{
+		if(!HostSetupState.bActive || HostSetupState.Serial != Serial)
+		{
+			return;
+		}
+		HostSetupState.LobbyResult.Emplace(CreateLobbyResult);
+		TryFinishHostSetup();
+	});
+	SessionsInterface->CreateSession(MoveTemp(SessionParams)).OnComplete([this, Serial](const TOnlineResult<FCreateSession>& CreateSessionResult)
+	{
+		if(!HostSetupState.bActive || HostSetupState.Serial != Serial)
+		{
+			return;
+		}
+		HostSetupState.SessionResult.Emplace(CreateSessionResult);
+		TryFinishHostSetup();
+	});
+}
+
+void UOnlineSampleOnlineSubsystem::TryFinishHostSetup()
+{
+	using namespace UE::Online;
+
+	if(!HostSetupState.LobbyResult.IsSet() || !HostSetupState.SessionResult.IsSet())
+	{
+		return;
+	}
+
+	const TOnlineResult<FCreateLobby>& LobbyResult = HostSetupState.LobbyResult.GetValue();
+	const TOnlineResult<FCreateSession>& SessionResult = HostSetupState.SessionResult.GetValue();
+	ULocalPlayer* LocalPlayer = HostSetupState.LocalPlayer.Get();
+	ISessionsPtr SessionsInterface = OnlineServicesInfoInternal->SessionsInterface;
+
+	// 세션 생성 결과에는 세션이 없으므로 로컬 이름으로 꺼냅니다.
+	TSharedPtr<const ISession> CreatedSession;
+	if(SessionResult.IsOk() && SessionsInterface)
+	{
+		FGetSessionByName::Params GetSessionParams;
+		GetSessionParams.LocalName = HostSetupState.SessionName;
+		TOnlineResult<FGetSessionByName> GetSessionResult = SessionsInterface->GetSessionByName(MoveTemp(GetSessionParams));
+		if(GetSessionResult.IsOk())
+		{
+			CreatedSession = GetSessionResult.GetOkValue().Session;
+		}
+	}
+
+	if(LobbyResult.IsOk() && CreatedSession.IsValid() && LocalPlayer)
+	{
+		// 로비 상태는 둘 다 성공했을 때만 갱신하고, 완료 이벤트는 OnCreateLobbyAndSessionComplete 하나만 보냅니다.
+		ApplyCreatedLobby(LobbyResult.GetOkValue().Lobby);
+		NotifyLobbyUpdated();
+		// 실패했을 때 꺼야 할 비컨이 없도록 둘 다 성공한 뒤에 켭니다.
+		if(HostSetupState.bIsLanSession)
+		{
+			StartLanBeacon(HostSetupState.MaxPlayers);
+		}
+		const FLobbyStateEntry* Entry = LobbyStates.Find(LobbyResult.GetOkValue().Lobby->LobbyId);
+		FinishHostSetup(true, Entry ? Entry->Info : FBlueprintLobbyInfo(LobbyResult.GetOkValue().Lobby), FBlueprintSessionInfo(*CreatedSession));
+		return;
+	}
+
+	// 한쪽만 성공했으면 그쪽을 되돌립니다. 로컬 플레이어가 사라졌어도 저장해둔 계정으로 되돌립니다.
+	if(LobbyResult.IsOk())
+	{
+		UE_LOG(LogOnlineSampleOnlineSubsystem, Warning, TEXT("Rolling back lobby after session creation failed"));
+		if(ILobbiesPtr LobbiesInterface = OnlineServicesInfoInternal->LobbiesInterface)
+		{
+			FLeaveLobby::Params LeaveLobbyParams;
+			LeaveLobbyParams.LocalAccountId = HostSetupState.LocalAccountId;
+			LeaveLobbyParams.LobbyId = LobbyResult.GetOkValue().Lobby->LobbyId;
+			LobbiesInterface->LeaveLobby(MoveTemp(LeaveLobbyParams)).OnComplete([](const TOnlineResult<FLeaveLobby>& LeaveLobbyResult)
+			{
+				if(LeaveLobbyResult.IsError())
+				{
+					UE_LOG(LogOnlineSampleOnlineSubsystem, Error, TEXT("Lobby Rollback Failed : %s"), *LeaveLobbyResult.GetErrorValue().GetLogString());
+				}
+			});
+		}
+	}
+	else
+	{
+		UE_LOG(LogTemp, Error, TEXT("Create Lobby Failed : %s"), *LobbyResult.GetErrorValue().GetLogString());
+	}
+	// PrepareCreateLobbyParams가 이 로비를 위해 켠 응답기를 끕니다. 이미 호스팅 중인 로비가 쓰고 있으면 둡니다.
+	if(!CreatedLobby.IsValid())
+	{
+		StopQosResponder();
+	}
+	
+	if(SessionResult.IsOk())
+	{
+		UE_LOG(LogOnlineSampleOnlineSubsystem, Warning, TEXT("Rolling back session after lobby creation failed"));
+		if(SessionsInterface)
+		{
+			FLeaveSession::Params LeaveSessionParams;
+			LeaveSessionParams.LocalAccountId = HostSetupState.LocalAccountId;
+			LeaveSessionParams.SessionName = HostSetupState.SessionName;
+			LeaveSessionParams.bDestroySession = true;
+			SessionsInterface->LeaveSession(MoveTemp(LeaveSessionParams)).OnComplete([](const TOnlineResult<FLeaveSession>& LeaveSessionResult)
+			{
+				if(LeaveSessionResult.IsError())
+				{
+					UE_LOG(LogOnlineSampleOnlineSubsystem, Error, TEXT("Session Rollback Failed : %s"), *LeaveSessionResult.GetErrorValue().GetLogString());
+				}
+			});
+		}
+	}
+	else
+	{
+		UE_LOG(LogTemp, Error, TEXT("Session Creation Failed : %s"), *SessionResult.GetErrorValue().GetLogString());
+	}
+
+	FinishHostSetup(false, FBlueprintLobbyInfo(), FBlueprintSessionInfo());
+}
+
+void UOnlineSampleOnlineSubsystem::FinishHostSetup(bool bSucceeded, const FBlueprintLobbyInfo& LobbyInfo, const FBlueprintSessionInfo& SessionInfo)
+{
+	HostSetupState.bActive = false;
+	HostSetupState.LobbyResult.Reset();
+	HostSetupState.SessionResult.Reset();
+	HostSetupState.LocalPlayer.Reset();
+	HostSetupState.LocalAccountId = UE::Online::FAccountId();
+	HostSetupState.bIsLanSession = false;
+	HostSetupState.MaxPlayers = 0;
+
+	OnCreateLobbyAndSessionCompleteEvent.Broadcast(bSucceeded, LobbyInfo, SessionInfo);
+	K2_OnCreateLobbyAndSessionCompleteEvent.Broadcast(bSucceeded, LobbyInfo, SessionInfo);
+}
+
+void UOnlineSampleOnlineSubsystem::K2_FindLobbies(ULocalPlayer* LocalPlayer)
+{
+	UE::Online::FFindLobbies::Params FindLobbyParams;
+	FindLobbies(LocalPlayer, FindLobbyParams);
+}
+
+void UOnlineSampleOnlineSubsystem::K2_FindLobbiesWithQuery(ULocalPlayer* LocalPlayer, const FBlueprintLobbySearchQuery& Query)
+{
+	UE::Online::FFindLobbies::Params FindLobbyParams;
+	if(!CompileLobbySearchQuery(Query, FindLobbyParams))
+	{
+		OnFindLobbiesCompleteEvent.Broadcast(false);
+		K2_OnFindLobbiesCompleteEvent.Broadcast(false);
+		return;
+	}
+	
+	FindLobbies(LocalPlayer, FindLobbyParams);
+}
+
+bool UOnlineSampleOnlineSubsystem::CompileLobbySearchQuery(const FBlueprintLobbySearchQuery& Query, UE::Online::FFindLobbies::Params& FindLobbyParams)
+{
+	TArray<FString> QueryErrors;
+	if(!Query.Validate(QueryErrors))
+	{
+		for(const FString& QueryError : QueryErrors)
+		{
+			UE_LOG(LogOnlineSampleOnlineSubsystem, Error, TEXT("Invalid Lobby Search Filter - %s"), *QueryError);
+		}
+		return false;
+	}
+
+	Query.CompileTo(FindLobbyParams);
+	return true;
+}
+
+void UOnlineSampleOnlineSubsystem::FindLobbiesByUser(ULocalPlayer* LocalPlayer, const FBlueprintFriendInfo& FriendInfo)
+{
+	using namespace UE::Online;
+	FFindLobbies::Params FindLobbyParams;
+	FindLobbyParams.TargetUser = FriendInfo.FriendAccountId;
+	FindLobbies(LocalPlayer,FindLobbyParams);
+}
+
+void UOnlineSampleOnlineSubsystem::FindLobbies(ULocalPlayer* LocalPlayer, UE::Online::FFindLobbies::Params FindLobbyParams)
+{
+	using namespace UE::Online;
+	
+	if(!IsLoggedIn(LocalPlayer))
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Local Player is not logged in"));
+		return;
+	}
+
+	if(ILobbiesPtr LobbiesInterface = OnlineServicesInfoInternal->LobbiesInterface)
+	{
+		PrepareFindLobbiesParams(LocalPlayer, FindLobbyParams);
+		FindLobbyParams.MaxResults = MaxLobbySearchResults;
+		const uint32 SearchSerial = BeginLobbySearch();
+
+		if(!bEnableLobbySearchCache)
+		{
+			LobbiesInterface->FindLobbies(MoveTemp(FindLobbyParams)).OnComplete([this, SearchSerial](const TOnlineResult<FFindLobbies>& FindLobbiesResult)
+			{
+				if(SearchSerial == LobbySearchSerial)
+				{
+					HandleFindLobbies(FindLobbiesResult);
+				}
+			});
+			return;
+		}
+
+		PruneLobbySearchCache();
+		FString CacheKey = MakeLobbySearchCacheKey(FindLobbyParams);
+		
+		if(FLobbySearchCacheEntry* CacheEntry = LobbySearchCache.Find(CacheKey))
+		{
+			// 이미 나가 있는 같은 조건의 요청도 이 검색의 응답으로 받습니다.
+			CacheEntry->SearchSerial = SearchSerial;
+			CacheEntry->bServedFromCache = false;
+			
+			const double CacheAge = FPlatformTime::Seconds() - CacheEntry->FetchedTime;
+			if(CacheEntry->FetchedTime > 0.0 && CacheAge <= LobbySearchCacheMaxAgeSeconds)
+			{
+				// 캐시된 결과를 바로 돌려줍니다. QoS 정렬까지 끝난 순서 그대로입니다.
+				FoundLobbies.Reset(CacheEntry->Results.Num());
+				FoundLobbies.Append(CacheEntry->Results);
+				FoundLobbiesCacheKey = CacheKey;
+				CacheEntry->bServedFromCache = true;
+				
+				OnFindLobbiesCompleteEvent.Broadcast(true);
+				K2_OnFindLobbiesCompleteEvent.Broadcast(true);
+
+				// TTL 안이거나 이미 갱신 중이면 백엔드에 다시 묻지 않습니다.
+				if(CacheAge < LobbySearchCacheTTLSeconds || CacheEntry->bRefreshInFlight)
+				{
+					return;
+				}
+				UE_LOG(LogOnlineSampleOnlineSubsystem, Verbose, TEXT("Lobby search cache stale (%.1fs), refreshing in background"), CacheAge);
+			}
+			else if(CacheEntry->bRefreshInFlight)
+			{
+				// 같은 조건의 검색이 이미 진행 중이면 그 결과를 기다립니다.
+				return;
+			}
+		}
+
+		FLobbySearchCacheEntry& RequestEntry = LobbySearchCache.FindOrAdd(CacheKey);
+		RequestEntry.SearchSerial = SearchSerial;
+		RequestEntry.bRefreshInFlight = true;
+		LobbiesInterface->FindLobbies(MoveTemp(FindLobbyParams)).OnComplete([this, CacheKey = MoveTemp(CacheKey)]
+			(const TOnlineResult<FFindLobbies>& FindLobbiesResult)
+		{
+			HandleCachedFindLobbies(FindLobbiesResult, CacheKey);
+		});
+	}
+
+	
+}
+
+void UOnlineSampleOnlineSubsystem::PrepareFindLobbiesParams(ULocalPlayer* LocalPlayer, UE::Online::FFindLobbies::Params& FindLobbyParams)
+{
+	using namespace UE::Online;
+	
+	FindLobbyParams.LocalAccountId = GetOnlineUserInfo(LocalPlayer->GetPlatformUserId())->AccountId;
+	//FindLobbyParams.Filters.Emplace(FFindLobbySearchFilter{FName(TEXT("OSSv2")), ESchemaAttributeComparisonOp::Equals, true});
+		
+	FindLobbyParams.Filters.Emplace(FFindLobbySearchFilter{ FName(TEXT("PRESENCESEARCH")), ESchemaAttributeComparisonOp::Equals, true });
+}
+
+void UOnlineSampleOnlineSubsystem::K2_FindLobbiesPaged(ULocalPlayer* LocalPlayer, int32 PageSize, bool bAutoStream, const FBlueprintLobbySearchQuery& Query)
+{
+	UE::Online::FFindLobbies::Params FindLobbyParams;
+	if(!CompileLobbySearchQuery(Query, FindLobbyParams))
+	{
+		OnFindLobbiesCompleteEvent.Broadcast(false);
+		K2_OnFindLobbiesCompleteEvent.Broadcast(false);
+		return;
+	}
+	
+	FindLobbiesPaged(LocalPlayer, FindLobbyParams, PageSize, bAutoStream);
+}
+
+/// <summary>
+/// 로비를 한 번 검색하고 결과를 페이지로 나눠 FoundLobbies에 붙입니다.
+///		FoundLobbies는 최대 페이지 수만큼 미리 공간을 잡아두므로 페이지가 붙는 동안 재할당되지 않습니다
+/// </summary>
+/// <param name="PageSize">한 페이지에 붙일 로비 수입니다</param>
+/// <param name="bAutoStream">true면 결과가 오는 대로 마지막 페이지까지 모두 붙입니다</param>
+void UOnlineSampleOnlineSubsystem::FindLobbiesPaged(ULocalPlayer* LocalPlayer, UE::Online::FFindLobbies::Params FindLobbyParams, int32 PageSize, bool bAutoStream)
+{
+	using namespace UE::Online;
+	check(LocalPlayer);
+	
+	if(!IsLoggedIn(LocalPlayer))
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Local Player is not logged in"));
+		return;
+	}
+
+	ILobbiesPtr LobbiesInterface = OnlineServicesInfoInternal->LobbiesInterface;
+	if(!LobbiesInterface)
+	{
+		OnFindLobbiesCompleteEvent.Broadcast(false);
+		K2_OnFindLobbiesCompleteEvent.Broadcast(false);
+		return;
+	}
+
+	PrepareFindLobbiesParams(LocalPlayer, FindLobbyParams);
+	// 오프셋이 없으니 페이지마다 다시 묻지 않고, 받을 수 있는 만큼 한 번에 받아 클라이언트에서 나눕니다.
+	FindLobbyParams.MaxResults = FMath::Max(MaxPagedLobbySearchResults, 1);
+	
+	// 이전 검색의 응답이 늦게 와도 무시되도록 시리얼을 올립니다.
+	const uint32 SearchSerial = BeginLobbySearch();
+	LobbySearchCursor = FLobbySearchCursor();
+	LobbySearchCursor.PageSize = FMath::Max(PageSize, 1);
+	LobbySearchCursor.bAutoStream = bAutoStream;
+	LobbySearchCursor.bExhausted = false;
+	LobbySearchCursor.bSearchInFlight = true;
+
+	FoundLobbiesCacheKey.Reset();
+	FoundLobbies.Reset(FMath::Min(LobbySearchCursor.PageSize * FMath::Max(MaxLobbySearchPages, 1), FindLobbyParams.MaxResults));
+
+	LobbiesInterface->FindLobbies(MoveTemp(FindLobbyParams)).OnComplete([this, SearchSerial](const TOnlineResult<FFindLobbies>& FindLobbiesResult)
+	{
+		HandleFindLobbiesPage(FindLobbiesResult, SearchSerial);
+	});
+}
+
+bool UOnlineSampleOnlineSubsystem::FetchNextLobbyPage()
+{
+	if(!HasMoreLobbyPages() || LobbySearchCursor.bSearchInFlight)
+	{
+		return false;
+	}
+
+	AppendNextLobbyPage();
+	return true;
+}
+
+void UOnlineSampleOnlineSubsystem::CancelPagedLobbySearch()
+{
+	LobbySearchCursor.Results.Empty();
+	LobbySearchCursor.bSearchInFlight = false;
+	LobbySearchCursor.bExhausted = true;
+}
+
+uint32 UOnlineSampleOnlineSubsystem::BeginLobbySearch()
+{
+	CancelPagedLobbySearch();
+	return ++LobbySearchSerial;
+}
+
+bool UOnlineSampleOnlineSubsystem::HasMoreLobbyPages() const
+{
+	return !LobbySearchCursor.bExhausted;
+}
+
+bool UOnlineSampleOnlineSubsystem::PreloadLobbyMap(const FBlueprintLobbyInfo& LobbyInfo)
+{
+	if(!bEnableLobbyMapPreload || !LobbyInfo.Lobby.IsValid())
+	{
+		return false;
+	}
+
+	const FSoftObjectPath MapPath = ResolveLobbyMapPath(*LobbyInfo.Lobby);
+	if(MapPath.IsNull())
+	{
+		return false;
+	}
+
+	// 같은 레벨이면 이미 읽고 있거나 다 읽은 핸들을 그대로 씁니다.
+	if(LobbyMapPreloadHandle.IsValid() && PreloadedLobbyMapPath == MapPath)
+	{
+		return true;
+	}
+
+	CancelLobbyMapPreload();
+
+	UE_LOG(LogOnlineSampleOnlineSubsystem, Log, TEXT("Preloading lobby map %s"), *MapPath.ToString());
+	PreloadedLobbyMapPath = MapPath;
+	LobbyMapPreloadHandle = UAssetManager::GetStreamableManager().RequestAsyncLoad(MapPath, FStreamableDelegate(), FStreamableManager::AsyncLoadHighPriority);
+	return LobbyMapPreloadHandle.IsValid();
+}
+
+void UOnlineSampleOnlineSubsystem::CancelLobbyMapPreload()
+{
+	if(LobbyMapPreloadHandle.IsValid())
+	{
+		LobbyMapPreloadHandle->CancelHandle();
+		LobbyMapPreloadHandle.Reset();
+	}
+	PreloadedLobbyMapPath.Reset();
+}
+
+bool UOnlineSampleOnlineSubsystem::MakeLobbyMapName(const TSoftObjectPtr<UWorld>& LevelToTravel, FString& OutMapName) const
+{
+	if(LevelToTravel.IsNull())
+	{
+		OutMapName = TEXT("MAP1");
+		return true;
+	}
+
+	// 별칭이 있으면 긴 경로 대신 별칭을 씁니다.
+	const FSoftObjectPath LevelPath = LevelToTravel.ToSoftObjectPath();
+	const FString* Alias = LobbyMapAliases.FindKey(LevelPath);
+	OutMapName = Alias ? *Alias : LevelPath.GetLongPackageName();
+
+	const FOnlineSampleLobbySchema::FAttributeDescriptor* Descriptor = FOnlineSampleLobbySchema::Get().FindAttribute(FName(TEXT("MAPNAME")));
+	if(Descriptor && Descriptor->MaxSize > 0 && OutMapName.Len() > Descriptor->MaxSize)
+	{
+		UE_LOG(LogOnlineSampleOnlineSubsystem, Error, TEXT("Lobby MAPNAME %s is longer than MaxSize %d. Add a shorter alias for it to LobbyMapAliases"), *OutMapName, Descriptor->MaxSize);
+		return false;
+	}
+	return true;
+}
+
+FSoftObjectPath UOnlineSampleOnlineSubsystem::ResolveLobbyMapPath(const UE::Online::FLobby& Lobby) const
+{
+	const UE::Online::FSchemaVariant* MapNameAttribute = Lobby.Attributes.Find(FName(TEXT("MAPNAME")));
+	if(!MapNameAttribute)
+	{
+		return FSoftObjectPath();
+	}
+
+	const FString MapName = FOnlineSampleLobbySchema::VariantToString(*MapNameAttribute);
+	if(const FSoftObjectPath* AliasedPath = LobbyMapAliases.Find(MapName))
+	{
+		return *AliasedPath;
+	}
+	if(FPackageName::IsValidLongPackageName(MapName))
+	{
+		return FSoftObjectPath(MapName + TEXT(".") + FPackageName::GetShortName(MapName));
+	}
+	
+	UE_LOG(LogOnlineSampleOnlineSubsystem, Verbose, TEXT("Lobby MAPNAME %s does not resolve to a level"), *MapName);
+	return FSoftObjectPath();
+}
+
+void UOnlineSampleOnlineSubsystem::HandlePostLoadMapForPreload(UWorld* LoadedWorld)
+{
+	if(!LoadedWorld)
+	{
+		return;
+	}
+
+	const FString LoadedPackageName = LoadedWorld->GetOutermost()->GetName();
+	if(LobbyMapPreloadHandle.IsValid() && LoadedPackageName == PreloadedLobbyMapPath.GetLongPackageName())
+	{
+		LobbyMapPreloadHandle->ReleaseHandle();
+		LobbyMapPreloadHandle.Reset();
+		PreloadedLobbyMapPath.Reset();
+	}
+	if(HostMapPreloadHandle.IsValid() && LoadedPackageName == HostLevelToTravel.ToSoftObjectPath().GetLongPackageName())
+	{
+		HostMapPreloadHandle->ReleaseHandle();
+		HostMapPreloadHandle.Reset();
+	}
+}
+
+void UOnlineSampleOnlineSubsystem::HandleSeamlessTravelComplete(ULocalPlayer* LocalPlayer)
+{
+	UE_LOG(LogOnlineSampleOnlineSubsystem, Log, TEXT("Seamless travel complete for local player %d"), LocalPlayer ? LocalPlayer->GetLocalPlayerIndex() : INDEX_NONE);
+
+	// 심리스 트래블에서는 PostLoadMapWithWorld가 오지 않으니 여기서 핸들을 놓습니다.
+	HandlePostLoadMapForPreload(GetWorld());
+
+	for(const FLobbyStateEntry& Entry : LobbyStates.Entries)
+	{
+		MarkLobbyDirty(Entry.Info.Lobby->LobbyId);
+	}
+}
+
+bool UOnlineSampleOnlineSubsystem::StartQosResponder()
+{
+	if(!QosResponder)
+	{
+		QosResponder = MakeUnique<FOnlineSampleQosResponder>();
+	}
+	if(QosResponder->IsRunning())
+	{
+		return true;
+	}
+	
+	if(!QosResponder->Start(QosResponderPort))
+	{
+		UE_LOG(LogOnlineSampleOnlineSubsystem, Error, TEXT("Failed to start QoS responder on port %d"), QosResponderPort);
+		return false;
+	}
+	
+	UE_LOG(LogOnlineSampleOnlineSubsystem, Log, TEXT("QoS responder listening on %s"), *QosResponder->GetHostAddressString());
+	return true;
+}
+
+void UOnlineSampleOnlineSubsystem::StopQosResponder()
+{
+	QosResponder.Reset();
+}
+
+void UOnlineSampleOnlineSubsystem::ProbeQosAddress(const FString& HostAddress)
+{
+	if(!ManualQosProber)
+	{
+		ManualQosProber = MakeUnique<FOnlineSampleQosProber>();
+	}
+
+	const bool bStarted = ManualQosProber->Start({ HostAddress }, QosPingsPerHost, QosProbeTimeoutSeconds, [this, HostAddress](const TArray<float>& RttMs)
+	{
+		OnQosProbeCompleteEvent.Broadcast(HostAddress, RttMs[0]);
+		K2_OnQosProbeCompleteEvent.Broadcast(HostAddress, RttMs[0]);
+	});
+	
+	if(!bStarted)
+	{
+		OnQosProbeCompleteEvent.Broadcast(HostAddress, -1.f);
+		K2_OnQosProbeCompleteEvent.Broadcast(HostAddress, -1.f);
+	}
+}
+
+void UOnlineSampleOnlineSubsystem::RankFoundLobbiesByQos()
+{
+	using namespace UE::Online;
+
+	TArray<FString> HostAddresses;
+	TArray<FLobbyId> ProbedLobbyIds;
+	HostAddresses.Reserve(FoundLobbies.Num());
+	ProbedLobbyIds.Reserve(FoundLobbies.Num());
+	for(const FBlueprintLobbyInfo& LobbyInfo : FoundLobbies)
+	{
+		FString HostAddress = LobbyInfo.Lobby.IsValid() ? GetLobbyQosAddress(*LobbyInfo.Lobby) : FString();
+		if(!HostAddress.IsEmpty())
+		{
+			HostAddresses.Add(MoveTemp(HostAddress));
+			ProbedLobbyIds.Add(LobbyInfo.Lobby->LobbyId);
+		}
+	}
+
+	if(!LobbyQosProber)
+	{
+		LobbyQosProber = MakeUnique<FOnlineSampleQosProber>();
+	}
+	
+	const bool bStarted = !HostAddresses.IsEmpty() && LobbyQosProber->Start(HostAddresses, QosPingsPerHost, QosProbeTimeoutSeconds,
+		[this, ProbedLobbyIds = MoveTemp(ProbedLobbyIds)](const TArray<float>& RttMs)
+	{
+		// 프로브 도중 FoundLobbies가 바뀌었을 수 있으니 LobbyId로 다시 맞춥니다.
+		TMap<FLobbyId, float> RttByLobby;
+		RttByLobby.Reserve(ProbedLobbyIds.Num());
+		for(int32 Index = 0; Index < ProbedLobbyIds.Num(); ++Index)
+		{
+			RttByLobby.Add(ProbedLobbyIds[Index], RttMs[Index]);
+		}
+		for(FBlueprintLobbyInfo& LobbyInfo : FoundLobbies)
+		{
+			if(const float* Rtt = LobbyInfo.Lobby.IsValid() ? RttByLobby.Find(LobbyInfo.Lobby->LobbyId) : nullptr)
+			{
+				LobbyInfo.PingMs = *Rtt;
+			}
+		}
+		
+		SortFoundLobbiesByQos();
+		OnFoundLobbiesRankedEvent.Broadcast(true);
+		K2_OnFoundLobbiesRankedEvent.Broadcast(true);
+	});
+
+	// 잴 호스트가 없으면 인원 비율로만 정렬합니다.
+	if(!bStarted)
+	{
+		SortFoundLobbiesByQos();
+		OnFoundLobbiesRankedEvent.Broadcast(false);
+		K2_OnFoundLobbiesRankedEvent.Broadcast(false);
+	}
+}
+
+void UOnlineSampleOnlineSubsystem::SortFoundLobbiesByQos()
+{
+	// 꽉 찬 로비는 맨 뒤, 재지 못한 호스트는 타임아웃만큼 느린 것으로 봅니다.
+	const float UnmeasuredRttMs = QosProbeTimeoutSeconds * 1000.f;
+	auto GetScore = [this, UnmeasuredRttMs](const FBlueprintLobbyInfo& LobbyInfo)
+	{
+		if(LobbyInfo.MaxMembers > 0 && LobbyInfo.Members.Num() >= LobbyInfo.MaxMembers)
+		{
+			return MAX_flt;
+		}
+		const float FillRatio = LobbyInfo.MaxMembers > 0 ? static_cast<float>(LobbyInfo.Members.Num()) / LobbyInfo.MaxMembers : 0.f;
+		const float RttMs = LobbyInfo.PingMs >= 0.f ? LobbyInfo.PingMs : UnmeasuredRttMs;
+		return RttMs - QosFillRatioWeightMs * FillRatio;
+	};
+	
+	Algo::StableSortBy(FoundLobbies, GetScore);
+
+	// 다음 캐시 응답이 정렬된 순서로 나가도록 캐시 항목도 바꿉니다.
+	if(FLobbySearchCacheEntry* CacheEntry = FoundLobbiesCacheKey.IsEmpty() ? nullptr : LobbySearchCache.Find(FoundLobbiesCacheKey))
+	{
+		CacheEntry->Results = FoundLobbies;
+	}
+}
+
+FString UOnlineSampleOnlineSubsystem::GetLobbyQosAddress(const UE::Online::FLobby& Lobby)
+{
+	const UE::Online::FSchemaVariant* QosAddress = Lobby.Attributes.Find(FName(TEXT("QOSADDR")));
+	return QosAddress ? FOnlineSampleLobbySchema::VariantToString(*QosAddress) : FString();
+}
+
+void UOnlineSampleOnlineSubsystem::InvalidateLobbySearchCache()
+{
+	FoundLobbiesCacheKey.Reset();
+	// 진행 중인 요청의 결과는 도착하면 다시 캐시에 들어갑니다.
+	for(auto It = LobbySearchCache.CreateIterator(); It; ++It)
+	{
+		if(!It->Value.bRefreshInFlight)
+		{
+			It.RemoveCurrent();
+		}
+		else
+		{
+			It->Value.Results.Reset();
+			It->Value.FetchedTime = 0.0;
+		}
+	}
+}
+
+void UOnlineSampleOnlineSubsystem::PruneLobbySearchCache()
+{
+	const double Now = FPlatformTime::Seconds();
+	for(auto It = LobbySearchCache.CreateIterator(); It; ++It)
+	{
+		if(!It->Value.bRefreshInFlight && Now - It->Value.FetchedTime > LobbySearchCacheMaxAgeSeconds)
+		{
+			It.RemoveCurrent();
+		}
+	}
+}
+
+/// <summary>
+/// 검색 파라미터를 캐시 키로 정규화합니다.
+///		필터 순서가 달라도 같은 키가 되도록 정렬하고, 로컬 계정은 키에 넣지 않습니다
+/// </summary>
+FString UOnlineSampleOnlineSubsystem::MakeLobbySearchCacheKey(const UE::Online::FFindLobbies::Params& FindLobbyParams)
+{
+	using namespace UE::Online;
+
+	TArray<FString> FilterKeys;
+	FilterKeys.Reserve(FindLobbyParams.Filters.Num());
+	for(const FFindLobbySearchFilter& Filter : FindLobbyParams.Filters)
+	{
+		FilterKeys.Add(FString::Printf(TEXT("%s|%d|%s"), *Filter.AttributeName.ToString(), static_cast<int32>(Filter.ComparisonOp), *Filter.ComparisonValue.ToLogString()));
 	}
-	//
-	NotifyLobbyUpdated();
+	FilterKeys.Sort();
+
+	FString CacheKey = FString::Printf(TEXT("Max=%u;"), FindLobbyParams.MaxResults);
+	if(FindLobbyParams.TargetUser.IsSet())
+	{
+		CacheKey += FString::Printf(TEXT("User=%u;"), FindLobbyParams.TargetUser->GetHandle());
+	}
+	if(FindLobbyParams.LobbyId.IsSet())
+	{
+		CacheKey += FString::Printf(TEXT("Lobby=%u;"), FindLobbyParams.LobbyId->GetHandle());
+	}
+	CacheKey += FString::Join(FilterKeys, TEXT(";"));
+	return CacheKey;
 }
 
+void UOnlineSampleOnlineSubsystem::K2_JoinLobby(ULocalPlayer* LocalPlayer, const FBlueprintLobbyInfo& LobbyInfoToJoin)
+{
+	JoinLobby(LocalPlayer, LobbyInfoToJoin);
+}
 
-/// <summary>
-/// 온라인 서비스를 초기화합니다.
-///		서비스에 대한 포인터를 가져옵니다
-///		인터페이스에 대한 포인터를 가져옵니다
-///		이벤트 핸들을 추가합니다
-///		포인터 유효성을 확인합니다
-/// </summary>
-void UOnlineSampleOnlineSubsystem::InitializeOnlineServices()
+void UOnlineSampleOnlineSubsystem::JoinFriendLobby(ULocalPlayer* LocalPlayer, const FBlueprintFriendInfo& FriendInfo)
 {
-	OnlineServicesInfoInternal = new FOnlineServicesInfo();
- 
-	// 서비스 포인터를 초기화합니다
-	OnlineServicesInfoInternal->OnlineServices = UE::Online::GetServices();
-	check(OnlineServicesInfoInternal->OnlineServices.IsValid());
- 
-	// 서비스 타입을 검증합니다
-	OnlineServicesInfoInternal->OnlineServicesType = OnlineServicesInfoInternal->OnlineServices->GetServicesProvider();
-	if (OnlineServicesInfoInternal->OnlineServices.IsValid())
+	using namespace UE::Online;
+	check(LocalPlayer);
+
+	// 이전 요청의 응답은 Serial로 버립니다.
+	++JoinFriendState.Serial;
+	JoinFriendState.bActive = false;
+
+	if(!IsLoggedIn(LocalPlayer))
 	{
-		// 인터페이스 포인터를 초기화합니다
-		OnlineServicesInfoInternal->AuthInterface = OnlineServicesInfoInternal->OnlineServices->GetAuthInterface();
-		check(OnlineServicesInfoInternal->AuthInterface.IsValid());
- 
-		OnlineServicesInfoInternal->TitleFileInterface = OnlineServicesInfoInternal->OnlineServices->GetTitleFileInterface();
-		check(OnlineServicesInfoInternal->TitleFileInterface.IsValid());
+		UE_LOG(LogTemp, Warning, TEXT("Local Player is not logged in"));
+		FinishJoinFriendLobby(false, FBlueprintLobbyInfo());
+		return;
+	}
 
-		//자 이번엔 내가 따라서 세션 인터페이스를 추가해보자.
-		OnlineServicesInfoInternal->SessionsInterface = OnlineServicesInfoInternal->OnlineServices->GetSessionsInterface();
-		check(OnlineServicesInfoInternal->SessionsInterface.IsValid());
+	if(!FriendInfo.FriendAccountId.IsValid())
+	{
+		UE_LOG(LogOnlineSampleOnlineSubsystem, Warning, TEXT("Friend %d has no valid account id"), FriendInfo.FriendId);
+		FinishJoinFriendLobby(false, FBlueprintLobbyInfo());
+		return;
+	}
 
-		OnlineServicesInfoInternal->LobbiesInterface = OnlineServicesInfoInternal->OnlineServices->GetLobbiesInterface();
-		check(OnlineServicesInfoInternal->LobbiesInterface.IsValid());
+	// 받아둔 현재 상태로 참가할 수 없는 친구면 요청을 보내지 않습니다.
+	if(const FBlueprintPresenceInfo* Presence = FriendPresences.Find(FriendInfo.FriendId))
+	{
+		const bool bOffline = Presence->Status == EBlueprintPresenceStatus::Offline;
+		const bool bNotJoinable = Presence->Joinability == EBlueprintPresenceJoinability::InviteOnly
+			|| Presence->Joinability == EBlueprintPresenceJoinability::Private;
+		if(bOffline || bNotJoinable)
+		{
+			UE_LOG(LogOnlineSampleOnlineSubsystem, Log, TEXT("Friend %d is not joinable (Offline : %d)"), FriendInfo.FriendId, bOffline);
+			FinishJoinFriendLobby(false, FBlueprintLobbyInfo());
+			return;
+		}
+	}
 
-		OnlineServicesInfoInternal->SocialInterface = OnlineServicesInfoInternal->OnlineServices->GetSocialInterface();
-		check(OnlineServicesInfoInternal->SocialInterface.IsValid());
+	// 이 플레이어가 이미 친구와 같은 로비에 있으면 할 일이 없습니다.
+	//		다른 로컬 플레이어만 들어가 있는 로비는 이 플레이어의 참가로 치지 않습니다.
+	const FAccountId LocalAccountId = GetOnlineUserInfo(LocalPlayer->GetPlatformUserId())->AccountId;
+	for(const FLobbyStateEntry& Entry : LobbyStates.Entries)
+	{
+		if(Entry.Info.Lobby.IsValid() && Entry.Info.Lobby->Members.Contains(LocalAccountId)
+			&& Entry.Info.Lobby->Members.Contains(FriendInfo.FriendAccountId))
+		{
+			FinishJoinFriendLobby(true, Entry.Info);
+			return;
+		}
+	}
 
-		OnlineServicesInfoInternal->UserInfoInterface = OnlineServicesInfoInternal->OnlineServices->GetUserInfoInterface();
-		check(OnlineServicesInfoInternal->UserInfoInterface.IsValid());
+	JoinFriendState.LocalPlayer = LocalPlayer;
+	JoinFriendState.FriendAccountId = FriendInfo.FriendAccountId;
+	JoinFriendState.bUsedSearch = false;
+	JoinFriendState.bActive = true;
 
-		OnlineServicesInfoInternal->PresenceInterface = OnlineServicesInfoInternal->OnlineServices->GetPresenceInterface();
-		check(OnlineServicesInfoInternal->PresenceInterface.IsValid());
-		
-		
+	if(TSharedPtr<const FLobby> KnownLobby = FindKnownFriendLobby(FriendInfo.FriendAccountId))
+	{
+		SendFriendLobbyJoin(KnownLobby.ToSharedRef());
 	}
-	else {
-		UE_LOG(LogOnlineSampleOnlineSubsystem, Error, TEXT("Error: Failed to initialize services."));
+	else
+	{
+		SearchFriendLobby();
 	}
 }
- 
 
-/// <summary>
-/// 로컬 레지스트리 OnlineUserInfos에 온라인 사용자를 등록합니다
-/// </summary>
-/// <param name="PlatformUserId">등록할 사용자의 플랫폼 사용자 ID입니다</param>
-void UOnlineSampleOnlineSubsystem::RegisterLocalOnlineUser(FPlatformUserId PlatformUserId)
+TSharedPtr<const UE::Online::FLobby> UOnlineSampleOnlineSubsystem::FindKnownFriendLobby(const UE::Online::FAccountId& FriendAccountId) const
 {
 	using namespace UE::Online;
- 
-	FAuthGetLocalOnlineUserByPlatformUserId::Params GetUserParams;
-	//GetUserParams.
-	GetUserParams.PlatformUserId = PlatformUserId;
-	if (OnlineServicesInfoInternal->AuthInterface.IsValid())
+
+	auto IsFriendLobby = [&FriendAccountId](const FBlueprintLobbyInfo& LobbyInfo)
 	{
-		TOnlineResult<FAuthGetLocalOnlineUserByPlatformUserId> AuthGetResult = OnlineServicesInfoInternal->AuthInterface->GetLocalOnlineUserByPlatformUserId(MoveTemp(GetUserParams));
- 
-		if (AuthGetResult.IsOk())
+		return LobbyInfo.Lobby.IsValid() && LobbyInfo.Lobby->Members.Contains(FriendAccountId)
+			&& (LobbyInfo.MaxMembers <= 0 || LobbyInfo.Members.Num() < LobbyInfo.MaxMembers);
+	};
+
+	if(const FBlueprintLobbyInfo* LobbyInfo = FoundLobbies.FindByPredicate(IsFriendLobby))
+	{
+		return LobbyInfo->Lobby;
+	}
+
+	// 캐시는 만료 전 항목 중 가장 최근에 받은 결과를 씁니다.
+	const double Now = FPlatformTime::Seconds();
+	TSharedPtr<const FLobby> BestLobby;
+	double BestFetchedTime = 0.0;
+	for(const TPair<FString, FLobbySearchCacheEntry>& CacheEntry : LobbySearchCache)
+	{
+		if(CacheEntry.Value.FetchedTime <= BestFetchedTime || Now - CacheEntry.Value.FetchedTime > LobbySearchCacheMaxAgeSeconds)
 		{
-			FAuthGetLocalOnlineUserByPlatformUserId::Result& LocalOnlineUser = AuthGetResult.GetOkValue();
-			TSharedRef<FAccountInfo> UserAccountInfo = LocalOnlineUser.AccountInfo;
-			FAccountInfo UserAccountInfoContent = *UserAccountInfo;
-			if (!OnlineUserInfos.Contains(UserAccountInfoContent.PlatformUserId))
-			{
-				UOnlineUserInfo* NewUser = CreateAndRegisterUserInfo(UserAccountInfoContent.AccountId.GetHandle(), PlatformUserId, UserAccountInfoContent.AccountId, UserAccountInfoContent.AccountId.GetOnlineServicesType());
- 
-				UE_LOG(LogOnlineSampleOnlineSubsystem, Log, TEXT("Local User Registered: %s"), *(NewUser->DebugInfoToString()));
-			}
-			else
+			continue;
+		}
+		if(const FBlueprintLobbyInfo* LobbyInfo = CacheEntry.Value.Results.FindByPredicate(IsFriendLobby))
+		{
+			BestLobby = LobbyInfo->Lobby;
+			BestFetchedTime = CacheEntry.Value.FetchedTime;
+		}
+	}
+	return BestLobby;
+}
+
+void UOnlineSampleOnlineSubsystem::SendFriendLobbyJoin(const TSharedRef<const UE::Online::FLobby>& Lobby)
+{
+	using namespace UE::Online;
+
+	ULocalPlayer* LocalPlayer = JoinFriendState.LocalPlayer.Get();
+	ILobbiesPtr LobbiesInterface = OnlineServicesInfoInternal->LobbiesInterface;
+	if(!LocalPlayer || !IsLoggedIn(LocalPlayer) || !LobbiesInterface)
+	{
+		FinishJoinFriendLobby(false, FBlueprintLobbyInfo());
+		return;
+	}
+
+	FJoinLobby::Params JoinLobbyParams;
+	JoinLobbyParams.LocalAccountId = GetOnlineUserInfo(LocalPlayer->GetPlatformUserId())->AccountId;
+	JoinLobbyParams.LobbyId = Lobby->LobbyId;
+	JoinLobbyParams.bPresenceEnabled = true;
+	JoinLobbyParams.LocalName = NAME_GameSession;
+	PendingLobbyJoins.Add(JoinLobbyParams.LobbyId, JoinLobbyParams.LocalAccountId);
+	LobbiesInterface->JoinLobby(MoveTemp(JoinLobbyParams)).OnComplete([this, Serial = JoinFriendState.Serial, WeakLocalPlayer = JoinFriendState.LocalPlayer,
+		LobbyId = Lobby->LobbyId, LocalAccountId = GetOnlineUserInfo(LocalPlayer->GetPlatformUserId())->AccountId]
+		(const TOnlineResult<FJoinLobby>& JoinLobbyResult)
+	{
+		PendingLobbyJoins.Remove(LobbyId);
+		if(!JoinFriendState.bActive || JoinFriendState.Serial != Serial)
+		{
+			// 취소된 뒤에 참가가 끝났으면 바로 나갑니다.
+			if(JoinLobbyResult.IsOk())
 			{
-				UE_LOG(LogOnlineSampleOnlineSubsystem, Log, TEXT("Local User with platform user id %d already registered."), PlatformUserId.GetInternalId());
+				if(ULocalPlayer* LocalPlayer = WeakLocalPlayer.Get())
+				{
+					LeaveLobby(LocalPlayer->GetPlatformUserId(), JoinLobbyResult.GetOkValue().Lobby->LobbyId);
+				}
 			}
+			return;
 		}
-		else
+
+		if(JoinLobbyResult.IsOk())
 		{
-			FOnlineError ErrorResult = AuthGetResult.GetErrorValue();
-			UE_LOG(LogOnlineSampleOnlineSubsystem, Error, TEXT("Get Local Online User Error: %s"), *ErrorResult.GetLogString());
+			const FLobbyId JoinedLobbyId = JoinLobbyResult.GetOkValue().Lobby->LobbyId;
+			HandleJoinLobby(JoinLobbyResult, LocalAccountId);
+			const FLobbyStateEntry* Entry = LobbyStates.Find(JoinedLobbyId);
+			FinishJoinFriendLobby(true, Entry ? Entry->Info : FBlueprintLobbyInfo(JoinLobbyResult.GetOkValue().Lobby));
+			return;
 		}
-	}
-	else
+
+		UE_LOG(LogTemp, Error, TEXT("Join Friend Lobby Failed : %s"), *JoinLobbyResult.GetErrorValue().GetLogString());
+		
+		// 받아둔 로비가 오래되어 실패했을 수 있으니 한 번은 친구를 대상으로 다시 찾습니다.
+		if(!JoinFriendState.bUsedSearch)
+		{
+			SearchFriendLobby();
+			return;
+		}
+		FinishJoinFriendLobby(false, FBlueprintLobbyInfo());
+	});
+}
+
+void UOnlineSampleOnlineSubsystem::SearchFriendLobby()
+{
+	using namespace UE::Online;
+
+	ULocalPlayer* LocalPlayer = JoinFriendState.LocalPlayer.Get();
+	ILobbiesPtr LobbiesInterface = OnlineServicesInfoInternal->LobbiesInterface;
+	if(!LocalPlayer || !IsLoggedIn(LocalPlayer) || !LobbiesInterface)
 	{
-		UE_LOG(LogOnlineSampleOnlineSubsystem, Error, TEXT("Auth Interface pointer invalid."));
+		FinishJoinFriendLobby(false, FBlueprintLobbyInfo());
+		return;
 	}
+
+	JoinFriendState.bUsedSearch = true;
+
+	// FoundLobbies와 검색 캐시는 건드리지 않는 별도 검색입니다.
+	FFindLobbies::Params FindLobbyParams;
+	PrepareFindLobbiesParams(LocalPlayer, FindLobbyParams);
+	FindLobbyParams.TargetUser = JoinFriendState.FriendAccountId;
+	FindLobbyParams.MaxResults = 1;
+	LobbiesInterface->FindLobbies(MoveTemp(FindLobbyParams)).OnComplete([this, Serial = JoinFriendState.Serial]
+		(const TOnlineResult<FFindLobbies>& FindLobbiesResult)
+	{
+		if(!JoinFriendState.bActive || JoinFriendState.Serial != Serial)
+		{
+			return;
+		}
+
+		if(FindLobbiesResult.IsOk() && FindLobbiesResult.GetOkValue().Lobbies.Num() > 0)
+		{
+			SendFriendLobbyJoin(FindLobbiesResult.GetOkValue().Lobbies[0]);
+			return;
+		}
+
+		if(FindLobbiesResult.IsError())
+		{
+			UE_LOG(LogTemp, Error, TEXT("Find Friend Lobby Failed : %s"), *FindLobbiesResult.GetErrorValue().GetLogString());
+		}
+		FinishJoinFriendLobby(false, FBlueprintLobbyInfo());
+	});
 }
 
-void UOnlineSampleOnlineSubsystem::K2_CreateSession(int32 MaxPlayer, bool IsLan, FPlatformUserId PlatformUserId)
+void UOnlineSampleOnlineSubsystem::FinishJoinFriendLobby(bool bSucceeded, const FBlueprintLobbyInfo& LobbyInfo)
+{
+	const bool bUsedSearch = JoinFriendState.bActive && JoinFriendState.bUsedSearch;
+	JoinFriendState.bActive = false;
+	JoinFriendState.LocalPlayer.Reset();
+
+	OnJoinFriendLobbyCompleteEvent.Broadcast(bSucceeded, LobbyInfo, bUsedSearch);
+	K2_OnJoinFriendLobbyCompleteEvent.Broadcast(bSucceeded, LobbyInfo, bUsedSearch);
+}
+
+void UOnlineSampleOnlineSubsystem::JoinLobby(ULocalPlayer* LocalPlayer, const FBlueprintLobbyInfo& LobbyInfoToJoin)
 {
+	using namespace UE::Online;
+	check(LocalPlayer);
 
+	if(!IsLoggedIn(LocalPlayer))
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Local Player is not logged in"));
+		return;
+	}
 	
-	UE::Online::FCreateSession::Params SessionParams;
-	SessionParams.bPresenceEnabled = true;
-	SessionParams.bIsLANSession = IsLan;
-	SessionParams.SessionSettings.NumMaxConnections = MaxPlayer;
-	SessionParams.SessionSettings.SchemaName = TEXT("GameSession");
-	SessionParams.SessionName = TEXT("MySessionName");
-	//SessionParams.LocalAccountId = 
-	//SessionParams.LocalAccountId = 0;
+	if(ILobbiesPtr LobbiesInterface = OnlineServicesInfoInternal->LobbiesInterface)
+	{
+		const FName SessionName(NAME_GameSession);//
+		
+		FJoinLobby::Params JoinLobbyParams;
+		const FLobby* LobbyToJoin = LobbyInfoToJoin.Lobby.Get();
+		
+		JoinLobbyParams.LocalAccountId = GetOnlineUserInfo(LocalPlayer->GetPlatformUserId())->AccountId;
+		JoinLobbyParams.LobbyId = LobbyToJoin->LobbyId;
+		JoinLobbyParams.bPresenceEnabled = true;
+		//JoinLobbyParams.LocalName = LobbyToJoin->LocalName;
+		JoinLobbyParams.LocalName = SessionName;//
+		PendingLobbyJoins.Add(JoinLobbyParams.LobbyId, JoinLobbyParams.LocalAccountId);
+		LobbiesInterface->JoinLobby(MoveTemp(JoinLobbyParams)).OnComplete([this, LobbyId = LobbyToJoin->LobbyId, LocalAccountId = GetOnlineUserInfo(LocalPlayer->GetPlatformUserId())->AccountId]
+			(const TOnlineResult<FJoinLobby>& JoinLobbyResult)
+		{
+			PendingLobbyJoins.Remove(LobbyId);
+			HandleJoinLobby(JoinLobbyResult, LocalAccountId);
+		});
+		
+	}
+}
 
-	CreateSession(SessionParams, PlatformUserId);
+void UOnlineSampleOnlineSubsystem::JoinLobbyWithFailover(ULocalPlayer* LocalPlayer, const FBlueprintLobbyInfo& LobbyInfoToJoin)
+{
+	using namespace UE::Online;
+	check(LocalPlayer);
+
+	CancelJoinLobbyWithFailover();
+
+	if(!IsLoggedIn(LocalPlayer) || !LobbyInfoToJoin.Lobby.IsValid())
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Local Player is not logged in"));
+		OnJoinLobbyWithFailoverCompleteEvent.Broadcast(false, FBlueprintLobbyInfo(), TArray<FBlueprintLobbyJoinAttempt>());
+		K2_OnJoinLobbyWithFailoverCompleteEvent.Broadcast(false, FBlueprintLobbyInfo(), TArray<FBlueprintLobbyJoinAttempt>());
+		return;
+	}
+
+	// 고른 로비를 맨 앞에 두고, 나머지는 마지막 검색 결과 순서대로 붙입니다.
+	JoinFailoverState.Candidates.Reset();
+	JoinFailoverState.Candidates.Add(LobbyInfoToJoin.Lobby.ToSharedRef());
+	for(const FBlueprintLobbyInfo& LobbyInfo : FoundLobbies)
+	{
+		if(JoinFailoverState.Candidates.Num() >= FMath::Max(JoinMaxCandidates, 1))
+		{
+			break;
+		}
+		if(!LobbyInfo.Lobby.IsValid() || LobbyInfo.Lobby->LobbyId == LobbyInfoToJoin.Lobby->LobbyId || LobbyStates.Indices.Contains(LobbyInfo.Lobby->LobbyId))
+		{
+			continue;
+		}
+		if(LobbyInfo.MaxMembers > 0 && LobbyInfo.Members.Num() >= LobbyInfo.MaxMembers)
+		{
+			continue;
+		}
+		JoinFailoverState.Candidates.Add(LobbyInfo.Lobby.ToSharedRef());
+	}
+
+	JoinFailoverState.LocalPlayer = LocalPlayer;
+	JoinFailoverState.Attempts.Reset();
+	JoinFailoverState.CandidateIndex = 0;
+	JoinFailoverState.RetryIndex = 0;
+	JoinFailoverState.bActive = true;
+	++JoinFailoverState.Serial;
+
+	SendFailoverJoin();
 }
 
-void UOnlineSampleOnlineSubsystem::CreateSession(UE::Online::FCreateSession::Params SessionParams, FPlatformUserId PlatformUserId)
+void UOnlineSampleOnlineSubsystem::CancelJoinLobbyWithFailover()
+{
+	if(JoinFailoverState.bActive)
+	{
+		FinishJoinLobbyWithFailover(false, FBlueprintLobbyInfo());
+	}
+}
+
+void UOnlineSampleOnlineSubsystem::SendFailoverJoin()
 {
 	using namespace UE::Online;
 
-	ISessionsPtr SessionInterface = OnlineServicesInfoInternal->SessionsInterface;
+	ULocalPlayer* LocalPlayer = JoinFailoverState.LocalPlayer.Get();
+	ILobbiesPtr LobbiesInterface = OnlineServicesInfoInternal->LobbiesInterface;
+	if(!JoinFailoverState.bActive || !LocalPlayer || !IsLoggedIn(LocalPlayer) || !LobbiesInterface)
+	{
+		FinishJoinLobbyWithFailover(false, FBlueprintLobbyInfo());
+		return;
+	}
 
-	 if(OnlineUserInfos.Contains(PlatformUserId))
-	 {
+	const TSharedRef<const FLobby>& LobbyToJoin = JoinFailoverState.Candidates[JoinFailoverState.CandidateIndex];
+	
+	FJoinLobby::Params JoinLobbyParams;
+	JoinLobbyParams.LocalAccountId = GetOnlineUserInfo(LocalPlayer->GetPlatformUserId())->AccountId;
+	JoinLobbyParams.LobbyId = LobbyToJoin->LobbyId;
+	JoinLobbyParams.bPresenceEnabled = true;
+	JoinLobbyParams.LocalName = NAME_GameSession;
+
+	JoinFailoverState.AttemptStartTime = FPlatformTime::Seconds();
+	PendingLobbyJoins.Add(JoinLobbyParams.LobbyId, JoinLobbyParams.LocalAccountId);
+	LobbiesInterface->JoinLobby(MoveTemp(JoinLobbyParams)).OnComplete([this, Serial = JoinFailoverState.Serial, LobbyId = LobbyToJoin->LobbyId, LocalAccountId = GetOnlineUserInfo(LocalPlayer->GetPlatformUserId())->AccountId]
+		(const TOnlineResult<FJoinLobby>& JoinLobbyResult)
+	{
+		PendingLobbyJoins.Remove(LobbyId);
+		HandleFailoverJoin(JoinLobbyResult, Serial, LocalAccountId);
+	});
+}
+
+void UOnlineSampleOnlineSubsystem::HandleFailoverJoin(const UE::Online::TOnlineResult<UE::Online::FJoinLobby>& JoinLobbyResult, uint32 Serial, UE::Online::FAccountId LocalAccountId)
+{
+	using namespace UE::Online;
+	
+	if(!JoinFailoverState.bActive || JoinFailoverState.Serial != Serial)
+	{
+		// 취소된 뒤에 참가가 끝났으면 바로 나갑니다. 그 사이에 새 요청이 상태를 바꿨거나
+		// 플레이어가 로그아웃했을 수 있으니, 참가를 보낸 계정으로 직접 나갑니다.
+		ILobbiesPtr LobbiesInterface = OnlineServicesInfoInternal->LobbiesInterface;
+		if(JoinLobbyResult.IsOk() && LobbiesInterface)
+		{
+			FLeaveLobby::Params LeaveLobbyParams;
+			LeaveLobbyParams.LocalAccountId = LocalAccountId;
+			LeaveLobbyParams.LobbyId = JoinLobbyResult.GetOkValue().Lobby->LobbyId;
+			LobbiesInterface->LeaveLobby(MoveTemp(LeaveLobbyParams)).OnComplete([](const TOnlineResult<FLeaveLobby>& LeaveLobbyResult)
+			{
+				if(LeaveLobbyResult.IsError())
+				{
+					UE_LOG(LogOnlineSampleOnlineSubsystem, Error, TEXT("Leaving Cancelled Join Failed : %s"), *LeaveLobbyResult.GetErrorValue().GetLogString());
+				}
+			});
+		}
+		return;
+	}
+
+	FBlueprintLobbyJoinAttempt& Attempt = JoinFailoverState.Attempts.AddDefaulted_GetRef();
+	Attempt.LobbyId = JoinFailoverState.Candidates[JoinFailoverState.CandidateIndex]->LobbyId.GetHandle();
+	Attempt.RetryIndex = JoinFailoverState.RetryIndex;
+	Attempt.DurationSeconds = static_cast<float>(FPlatformTime::Seconds() - JoinFailoverState.AttemptStartTime);
+
+	if(JoinLobbyResult.IsOk())
+	{
+		Attempt.bSucceeded = true;
+		const FLobbyId JoinedLobbyId = JoinLobbyResult.GetOkValue().Lobby->LobbyId;
+		HandleJoinLobby(JoinLobbyResult, LocalAccountId);
+
+		const FLobbyStateEntry* Entry = LobbyStates.Find(JoinedLobbyId);
+		FinishJoinLobbyWithFailover(true, Entry ? Entry->Info : FBlueprintLobbyInfo(JoinLobbyResult.GetOkValue().Lobby));
+		return;
+	}
+
+	const FOnlineError& Error = JoinLobbyResult.GetErrorValue();
+	Attempt.Error = Error.GetLogString();
+	Attempt.bTransientError = IsTransientJoinError(Error);
+	UE_LOG(LogOnlineSampleOnlineSubsystem, Warning, TEXT("Join Lobby attempt %d (retry %d) failed : %s"), JoinFailoverState.Attempts.Num(), Attempt.RetryIndex, *Attempt.Error);
 
-		TObjectPtr<const UOnlineUserInfo> OnlineUser = *OnlineUserInfos.Find(PlatformUserId);
-		FAccountId LocalAccountId = OnlineUser->AccountId;
-		SessionParams.LocalAccountId = LocalAccountId;
-		
-		if(SessionInterface.IsValid())
+	if(Attempt.bTransientError && JoinFailoverState.RetryIndex < JoinMaxRetriesPerLobby)
+	{
+		// 같은 로비에 몰린 요청끼리 다시 부딪히지 않도록 간격을 흩뜨립니다.
+		const float CappedDelay = FMath::Min(JoinRetryBaseDelaySeconds * FMath::Pow(2.f, static_cast<float>(JoinFailoverState.RetryIndex)), JoinRetryMaxDelaySeconds);
+		const float RetryDelay = CappedDelay * 0.5f + FMath::FRandRange(0.f, CappedDelay * 0.5f);
+		++JoinFailoverState.RetryIndex;
+
+		if(RetryDelay > 0.f)
 		{
-			SessionInterface->CreateSession(MoveTemp(SessionParams)).OnComplete(this, &ThisClass::HandleCreateSession);
+			GetGameInstance()->GetTimerManager().SetTimer(JoinFailoverState.RetryTimerHandle, this, &ThisClass::SendFailoverJoin, RetryDelay, false);
 		}
 		else
 		{
-			UE_LOG(LogOnlineSampleOnlineSubsystem, Error, TEXT("Sessions Interface pointer invalid."));
+			// 다음 틱 재시도도 핸들을 받아둬야 끝낼 때 ClearTimer로 취소됩니다.
+			JoinFailoverState.RetryTimerHandle = GetGameInstance()->GetTimerManager().SetTimerForNextTick(this, &ThisClass::SendFailoverJoin);
 		}
-	 }else
-	 {
-	 	UE_LOG(LogOnlineSampleOnlineSubsystem, Error, TEXT("Could not find user with Platform User Id: %d"), PlatformUserId.GetInternalId());
-	 }
+		return;
+	}
+
+	// 다시 해도 안 될 오류거나 재시도를 다 썼으면 기다리지 않고 다음 후보로 넘어갑니다.
+	JoinFailoverState.RetryIndex = 0;
+	if(++JoinFailoverState.CandidateIndex < JoinFailoverState.Candidates.Num())
+	{
+		SendFailoverJoin();
+		return;
+	}
+
+	FinishJoinLobbyWithFailover(false, FBlueprintLobbyInfo());
 }
 
-void UOnlineSampleOnlineSubsystem::FindSessions(UE::Online::FFindSessions::Params SessionFindParams)
+void UOnlineSampleOnlineSubsystem::FinishJoinLobbyWithFailover(bool bSucceeded, const FBlueprintLobbyInfo& LobbyInfo)
 {
-	using namespace UE::Online;
+	++JoinFailoverState.Serial;
+	JoinFailoverState.bActive = false;
+	JoinFailoverState.Candidates.Reset();
+	GetGameInstance()->GetTimerManager().ClearTimer(JoinFailoverState.RetryTimerHandle);
 
-	ISessionsPtr SessionInterface = OnlineServicesInfoInternal->SessionsInterface;
+	const TArray<FBlueprintLobbyJoinAttempt> Attempts = MoveTemp(JoinFailoverState.Attempts);
+	JoinFailoverState.Attempts.Reset();
 
-	if(SessionInterface.IsValid())
+	// 하나씩 실패할 때는 알리지 않고, 후보를 다 써버렸을 때만 참가 실패를 알립니다.
+	if(!bSucceeded && !Attempts.IsEmpty())
 	{
-		
-		UE_LOG(LogTemp, Warning, TEXT("Start FindSessions With Parameter - MaxResults : %d, LocalAccountId : %d"),
-			SessionFindParams.MaxResults, SessionFindParams.LocalAccountId.GetHandle());
-		
-		
-		SessionInterface->FindSessions(MoveTemp(SessionFindParams)).OnComplete([this, SessionInterface](const UE::Online::TOnlineResult<FFindSessions> &FindSessionsResult)
-		{
-			if(FindSessionsResult.IsOk())
-			{
-				TArray<FOnlineSessionId> SessionIds =  FindSessionsResult.GetOkValue().FoundSessionIds;
-				for(FOnlineSessionId SessionId : SessionIds)
-				{
-					FGetSessionById::Params GetSessionParams;
-					GetSessionParams.SessionId = SessionId;
-					TOnlineResult<FGetSessionById> GetSessionByIdResult =  SessionInterface->GetSessionById(MoveTemp(GetSessionParams));
-					if(GetSessionByIdResult.IsOk())
-					{
-						FBlueprintSessionInfo SessionInfo;
-						GetSessionByIdResult.GetOkValue().Session->DumpState();
-					}
-				}
-			}
-			else
-			{
-				UE_LOG(LogTemp, Error, TEXT("Find Sessions Failed : %s"), *FindSessionsResult.GetErrorValue().GetLogString())	
-			}
-			
-		});
-
-		
+		OnJoinLobbyCompleteEvent.Broadcast(false, LobbyInfo);
+		K2_OnJoinLobbyCompleteEvent.Broadcast(false, LobbyInfo);
 	}
+	
+	OnJoinLobbyWithFailoverCompleteEvent.Broadcast(bSucceeded, LobbyInfo, Attempts);
+	K2_OnJoinLobbyWithFailoverCompleteEvent.Broadcast(bSucceeded, LobbyInfo, Attempts);
 }
 
-void UOnlineSampleOnlineSubsystem::K2_CreateLobby(ULocalPlayer* LocalPlayer, const FCreateLobbyRequest& Request)
+bool UOnlineSampleOnlineSubsystem::IsTransientJoinError(const UE::Online::FOnlineError& Error)
 {
-	//
-	check(!Request.LevelToTravel.IsNull());//
+	using namespace UE::Online;
 	
-	CreateLobby(LocalPlayer, Request);
+	return Error == Errors::Timeout()
+		|| Error == Errors::NoConnection()
+		|| Error == Errors::RequestFailure()
+		|| Error == Errors::TooManyRequests();
 }
 
-void UOnlineSampleOnlineSubsystem::CreateLobby(ULocalPlayer* LocalPlayer,const FCreateLobbyRequest& Request)
+void UOnlineSampleOnlineSubsystem::QuickMatch(ULocalPlayer* LocalPlayer, const FQuickMatchRequest& Request)
 {
 	using namespace UE::Online;
-	
-	if(!IsLoggedIn(LocalPlayer))
+	check(LocalPlayer);
+
+	if(QuickMatchState.bActive)
 	{
-		UE_LOG(LogTemp, Warning, TEXT("Create Lobby Failed : Not Logged In"));
+		CancelQuickMatch();
+	}
+
+	ILobbiesPtr LobbiesInterface = OnlineServicesInfoInternal->LobbiesInterface;
+	if(!IsLoggedIn(LocalPlayer) || !LobbiesInterface)
+	{
+		UE_LOG(LogOnlineSampleOnlineSubsystem, Warning, TEXT("Quick Match Failed : Not Logged In"));
+		OnQuickMatchCompleteEvent.Broadcast(EQuickMatchResult::Failed, FBlueprintLobbyInfo());
+		K2_OnQuickMatchCompleteEvent.Broadcast(EQuickMatchResult::Failed, FBlueprintLobbyInfo());
 		return;
 	}
-	
-	
-	if(UE::Online::ILobbiesPtr LobbiesInterface = OnlineServicesInfoInternal->LobbiesInterface)
+
+	TArray<FBlueprintLobbySearchQuery> SearchTiers = Request.SearchTiers;
+	if(SearchTiers.IsEmpty())
 	{
-		UE::Online::FCreateLobby::Params CreateLobbyParams;
+		SearchTiers.AddDefaulted();
+	}
 
-		//const FName SessionName(NAME_GameSession); // 일단 일반 사용자 플러그인에서 긁어온거. 흠..
-		
-		CreateLobbyParams.SchemaId = FSchemaId(TEXT("GameLobby"));
-		CreateLobbyParams.LocalAccountId = GetOnlineUserInfo(LocalPlayer->GetPlatformUserId())->AccountId;
-		//CreateLobbyParams.LocalName = SessionName;
-		CreateLobbyParams.LocalName = Request.LobbyName;//
-		CreateLobbyParams.bPresenceEnabled = true;
-		CreateLobbyParams.JoinPolicy = UE::Online::ELobbyJoinPolicy::PublicAdvertised;
-		CreateLobbyParams.Attributes.Emplace(FName(TEXT("GAMEMODE")), FString(TEXT("GAMEMODE1")));
-		CreateLobbyParams.Attributes.Emplace(FName(TEXT("MAPNAME")), FString(TEXT("MAP1")));
-		//CreateLobbyParams.Attributes.Emplace(FName(TEXT("MATCHTIMEOUT")), 120.0f);
-		//CreateLobbyParams.Attributes.Emplace(FName(TEXT("SESSIONTEMPLATENAME")), FString(TEXT("GameSession")));
-		//CreateLobbyParams.Attributes.Emplace(FName(TEXT("OSSv2")), true);
-		CreateLobbyParams.Attributes.Emplace(FName(TEXT("PRESENCESEARCH")), true);
-		CreateLobbyParams.Attributes.Emplace(FName(TEXT("GAMEMODE")), FString(TEXT("GameSession")));
-		CreateLobbyParams.Attributes.Emplace(FName(TEXT("MATCHSTATE")), FString(TEXT("Waiting")));
-		
-		CreateLobbyParams.MaxMembers = Request.MaxPlayers;
+	const uint32 Serial = ++QuickMatchState.Serial;
+	QuickMatchState.Request = Request;
+	QuickMatchState.LocalPlayer = LocalPlayer;
+	QuickMatchState.TierCandidates.Reset();
+	QuickMatchState.TierCandidates.SetNum(SearchTiers.Num());
+	QuickMatchState.TriedLobbies.Reset();
+	QuickMatchState.PendingSearches = SearchTiers.Num();
+	QuickMatchState.bActive = true;
+	QuickMatchState.bJoinInFlight = false;
+	QuickMatchState.bCreateInFlight = false;
+	QuickMatchState.bDeadlinePassed = false;
+
+	// 0 이하면 모든 검색이 끝날 때까지 기다립니다.
+	if(Request.DeadlineSeconds > 0.f)
+	{
+		GetGameInstance()->GetTimerManager().SetTimer(QuickMatchState.DeadlineTimerHandle, this, &ThisClass::HandleQuickMatchDeadline, Request.DeadlineSeconds, false);
+	}
 
-		//유저 아트리뷰트
-		CreateLobbyParams.UserAttributes.Emplace(FName(TEXT("GAMEMODE")), FString(TEXT("GameSession")));
-		CreateLobbyParams.UserAttributes.Emplace(FName(TEXT("MATCHSTATE")), FString(TEXT("Waiting")));
-		
-		LobbiesInterface->CreateLobby(MoveTemp(CreateLobbyParams)).OnComplete(this, &ThisClass::HandleCreateLobby);
-		
+	// 검색을 순서대로 기다리지 않고 한꺼번에 보냅니다.
+	for(int32 TierIndex = 0; TierIndex < SearchTiers.Num(); ++TierIndex)
+	{
+		FFindLobbies::Params FindLobbyParams;
+		if(!CompileLobbySearchQuery(SearchTiers[TierIndex], FindLobbyParams))
+		{
+			--QuickMatchState.PendingSearches;
+			continue;
+		}
+		PrepareFindLobbiesParams(LocalPlayer, FindLobbyParams);
+		FindLobbyParams.MaxResults = MaxLobbySearchResults;
+
+		LobbiesInterface->FindLobbies(MoveTemp(FindLobbyParams)).OnComplete([this, Serial, TierIndex]
+			(const TOnlineResult<FFindLobbies>& FindLobbiesResult)
+		{
+			HandleQuickMatchSearch(FindLobbiesResult, Serial, TierIndex);
+		});
+	}
+
+	if(QuickMatchState.bActive && QuickMatchState.Serial == Serial && QuickMatchState.PendingSearches == 0)
+	{
+		TryQuickMatchJoin();
 	}
-	
 }
 
-void UOnlineSampleOnlineSubsystem::K2_FindLobbies(ULocalPlayer* LocalPlayer)
+void UOnlineSampleOnlineSubsystem::CancelQuickMatch()
 {
-	UE::Online::FFindLobbies::Params FindLobbyParams;
-	FindLobbies(LocalPlayer, FindLobbyParams);
+	if(QuickMatchState.bActive)
+	{
+		FinishQuickMatch(EQuickMatchResult::Cancelled, FBlueprintLobbyInfo());
+	}
 }
 
-void UOnlineSampleOnlineSubsystem::FindLobbiesByUser(ULocalPlayer* LocalPlayer, const FBlueprintFriendInfo& FriendInfo)
+bool UOnlineSampleOnlineSubsystem::IsQuickMatchInProgress() const
 {
-	using namespace UE::Online;
-	FFindLobbies::Params FindLobbyParams;
-	FindLobbyParams.TargetUser = FriendInfo.Friend->FriendId;
-	FindLobbies(LocalPlayer,FindLobbyParams);
+	return QuickMatchState.bActive;
 }
 
-void UOnlineSampleOnlineSubsystem::FindLobbies(ULocalPlayer* LocalPlayer, UE::Online::FFindLobbies::Params FindLobbyParams)
+void UOnlineSampleOnlineSubsystem::HandleQuickMatchSearch(const UE::Online::TOnlineResult<UE::Online::FFindLobbies>& FindLobbiesResult, uint32 Serial, int32 TierIndex)
 {
-	using namespace UE::Online;
-	
-	if(!IsLoggedIn(LocalPlayer))
+	if(!QuickMatchState.bActive || QuickMatchState.Serial != Serial)
 	{
-		UE_LOG(LogTemp, Warning, TEXT("Local Player is not logged in"));
 		return;
 	}
 
-	if(ILobbiesPtr LobbiesInterface = OnlineServicesInfoInternal->LobbiesInterface)
+	--QuickMatchState.PendingSearches;
+	if(FindLobbiesResult.IsOk())
 	{
-				
-		FindLobbyParams.LocalAccountId = GetOnlineUserInfo(LocalPlayer->GetPlatformUserId())->AccountId;
-		FindLobbyParams.MaxResults = 10;
-		//FindLobbyParams.Filters.Emplace(FFindLobbySearchFilter{FName(TEXT("OSSv2")), ESchemaAttributeComparisonOp::Equals, true});
-		
-		FindLobbyParams.Filters.Emplace(FFindLobbySearchFilter{ FName(TEXT("PRESENCESEARCH")), ESchemaAttributeComparisonOp::Equals, true });
-		
-		LobbiesInterface->FindLobbies(MoveTemp(FindLobbyParams)).OnComplete(this, &ThisClass::HandleFindLobbies);
+		QuickMatchState.TierCandidates[TierIndex].Append(FindLobbiesResult.GetOkValue().Lobbies);
+	}
+	else
+	{
+		UE_LOG(LogOnlineSampleOnlineSubsystem, Warning, TEXT("Quick Match search tier %d failed : %s"), TierIndex, *FindLobbiesResult.GetErrorValue().GetLogString());
 	}
 
-	
+	TryQuickMatchJoin();
 }
 
-void UOnlineSampleOnlineSubsystem::K2_JoinLobby(ULocalPlayer* LocalPlayer, const FBlueprintLobbyInfo& LobbyInfoToJoin)
+bool UOnlineSampleOnlineSubsystem::IsQuickMatchCandidate(const UE::Online::FLobby& Lobby) const
 {
-	JoinLobby(LocalPlayer, LobbyInfoToJoin);
+	if(QuickMatchState.TriedLobbies.Contains(Lobby.LobbyId) || LobbyStates.Indices.Contains(Lobby.LobbyId))
+	{
+		return false;
+	}
+	if(Lobby.MaxMembers > 0 && Lobby.Members.Num() >= static_cast<int32>(Lobby.MaxMembers))
+	{
+		return false;
+	}
+	// 이미 게임을 시작한 로비는 건너뜁니다.
+	const UE::Online::FSchemaVariant* MatchState = Lobby.Attributes.Find(FName(TEXT("MATCHSTATE")));
+	return !MatchState || FOnlineSampleLobbySchema::VariantToString(*MatchState) == TEXT("Waiting");
 }
 
-void UOnlineSampleOnlineSubsystem::JoinFriendLobby(ULocalPlayer* LocalPlayer, const FBlueprintFriendInfo& FriendInfo)
+void UOnlineSampleOnlineSubsystem::TryQuickMatchJoin()
+{
+	using namespace UE::Online;
+
+	if(!QuickMatchState.bActive || QuickMatchState.bJoinInFlight || QuickMatchState.bCreateInFlight)
+	{
+		return;
+	}
+
+	ULocalPlayer* LocalPlayer = QuickMatchState.LocalPlayer.Get();
+	ILobbiesPtr LobbiesInterface = OnlineServicesInfoInternal->LobbiesInterface;
+	if(!LocalPlayer || !IsLoggedIn(LocalPlayer) || !LobbiesInterface)
+	{
+		FinishQuickMatch(EQuickMatchResult::Failed, FBlueprintLobbyInfo());
+		return;
+	}
+
+	TSharedPtr<const FLobby> LobbyToJoin;
+	for(const TArray<TSharedRef<const FLobby>>& Candidates : QuickMatchState.TierCandidates)
+	{
+		for(const TSharedRef<const FLobby>& Candidate : Candidates)
+		{
+			if(IsQuickMatchCandidate(*Candidate))
+			{
+				LobbyToJoin = Candidate;
+				break;
+			}
+		}
+		if(LobbyToJoin.IsValid())
+		{
+			break;
+		}
+	}
+
+	if(!LobbyToJoin.IsValid())
+	{
+		// 기다릴 검색이 남아 있으면 마감 전까지 기다립니다.
+		if(QuickMatchState.PendingSearches == 0 || QuickMatchState.bDeadlinePassed)
+		{
+			StartQuickMatchFallback();
+		}
+		return;
+	}
+
+	QuickMatchState.TriedLobbies.Add(LobbyToJoin->LobbyId);
+	QuickMatchState.bJoinInFlight = true;
+
+	FJoinLobby::Params JoinLobbyParams;
+	JoinLobbyParams.LocalAccountId = GetOnlineUserInfo(LocalPlayer->GetPlatformUserId())->AccountId;
+	JoinLobbyParams.LobbyId = LobbyToJoin->LobbyId;
+	JoinLobbyParams.bPresenceEnabled = true;
+	JoinLobbyParams.LocalName = NAME_GameSession;
+	
+	PendingLobbyJoins.Add(JoinLobbyParams.LobbyId, JoinLobbyParams.LocalAccountId);
+	LobbiesInterface->JoinLobby(MoveTemp(JoinLobbyParams)).OnComplete([this, Serial = QuickMatchState.Serial, PlatformUserId = LocalPlayer->GetPlatformUserId(),
+		LobbyId = LobbyToJoin->LobbyId, LocalAccountId = GetOnlineUserInfo(LocalPlayer->GetPlatformUserId())->AccountId]
+		(const TOnlineResult<FJoinLobby>& JoinLobbyResult)
+	{
+		PendingLobbyJoins.Remove(LobbyId);
+		if(!QuickMatchState.bActive || QuickMatchState.Serial != Serial)
+		{
+			// 취소된 뒤에 참가가 끝났으면 바로 나갑니다.
+			if(JoinLobbyResult.IsOk())
+			{
+				LeaveLobby(PlatformUserId, JoinLobbyResult.GetOkValue().Lobby->LobbyId);
+			}
+			return;
+		}
+		
+		QuickMatchState.bJoinInFlight = false;
+		if(JoinLobbyResult.IsOk())
+		{
+			const FLobbyId JoinedLobbyId = JoinLobbyResult.GetOkValue().Lobby->LobbyId;
+			HandleJoinLobby(JoinLobbyResult, LocalAccountId);
+			
+			const FLobbyStateEntry* Entry = LobbyStates.Find(JoinedLobbyId);
+			FinishQuickMatch(EQuickMatchResult::Joined, Entry ? Entry->Info : FBlueprintLobbyInfo(JoinLobbyResult.GetOkValue().Lobby));
+			return;
+		}
+
+		// 그 사이 꽉 찼거나 닫힌 로비일 수 있으니 다음 후보로 넘어갑니다.
+		UE_LOG(LogOnlineSampleOnlineSubsystem, Warning, TEXT("Quick Match join failed : %s"), *JoinLobbyResult.GetErrorValue().GetLogString());
+		TryQuickMatchJoin();
+	});
+}
+
+void UOnlineSampleOnlineSubsystem::HandleQuickMatchDeadline()
 {
+	if(!QuickMatchState.bActive)
+	{
+		return;
+	}
 	
+	QuickMatchState.bDeadlinePassed = true;
+	TryQuickMatchJoin();
 }
 
-void UOnlineSampleOnlineSubsystem::JoinLobby(ULocalPlayer* LocalPlayer, const FBlueprintLobbyInfo& LobbyInfoToJoin)
+void UOnlineSampleOnlineSubsystem::StartQuickMatchFallback()
 {
 	using namespace UE::Online;
-	check(LocalPlayer);
-
-	if(!IsLoggedIn(LocalPlayer))
+	
+	ULocalPlayer* LocalPlayer = QuickMatchState.LocalPlayer.Get();
+	ILobbiesPtr LobbiesInterface = OnlineServicesInfoInternal->LobbiesInterface;
+	if(!QuickMatchState.Request.bCreateLobbyOnTimeout || !LocalPlayer || !IsLoggedIn(LocalPlayer) || !LobbiesInterface)
 	{
-		UE_LOG(LogTemp, Warning, TEXT("Local Player is not logged in"));
+		FinishQuickMatch(EQuickMatchResult::Failed, FBlueprintLobbyInfo());
 		return;
 	}
-	
-	if(ILobbiesPtr LobbiesInterface = OnlineServicesInfoInternal->LobbiesInterface)
+
+	FCreateLobby::Params CreateLobbyParams;
+	if(!PrepareCreateLobbyParams(LocalPlayer, QuickMatchState.Request.FallbackLobby, CreateLobbyParams))
 	{
-		const FName SessionName(NAME_GameSession);//
-		
-		FJoinLobby::Params JoinLobbyParams;
-		const FLobby* LobbyToJoin = LobbyInfoToJoin.Lobby.Get();
-		
-		JoinLobbyParams.LocalAccountId = GetOnlineUserInfo(LocalPlayer->GetPlatformUserId())->AccountId;
-		JoinLobbyParams.LobbyId = LobbyToJoin->LobbyId;
-		JoinLobbyParams.bPresenceEnabled = true;
-		//JoinLobbyParams.LocalName = LobbyToJoin->LocalName;
-		JoinLobbyParams.LocalName = SessionName;//
-		LobbiesInterface->JoinLobby(MoveTemp(JoinLobbyParams)).OnComplete(this, &ThisClass::HandleJoinLobby);	
-		
+		FinishQuickMatch(EQuickMatchResult::Failed, FBlueprintLobbyInfo());
+		return;
 	}
+
+	// 남은 검색 결과는 더 이상 보지 않습니다.
+	QuickMatchState.bCreateInFlight = true;
+	GetGameInstance()->GetTimerManager().ClearTimer(QuickMatchState.DeadlineTimerHandle);
+
+	UE_LOG(LogOnlineSampleOnlineSubsystem, Log, TEXT("Quick Match found no lobby, creating one"));
+	// 다른 곳의 로비 생성 결과와 섞이지 않도록 이 요청의 결과만 받습니다.
+	LobbiesInterface->CreateLobby(MoveTemp(CreateLobbyParams)).OnComplete([this, Serial = QuickMatchState.Serial, PlatformUserId = LocalPlayer->GetPlatformUserId()]
+		(const TOnlineResult<FCreateLobby>& CreateLobbyResult)
+	{
+		if(!QuickMatchState.bActive || QuickMatchState.Serial != Serial)
+		{
+			// 취소된 뒤에 만들어졌으면 바로 나갑니다.
+			if(CreateLobbyResult.IsOk())
+			{
+				LeaveLobby(PlatformUserId, CreateLobbyResult.GetOkValue().Lobby->LobbyId);
+			}
+			return;
+		}
+
+		HandleCreateLobby(CreateLobbyResult);
+
+		const FLobbyStateEntry* Entry = CreateLobbyResult.IsOk() ? LobbyStates.Find(CreateLobbyResult.GetOkValue().Lobby->LobbyId) : nullptr;
+		if(Entry)
+		{
+			FinishQuickMatch(EQuickMatchResult::Created, Entry->Info);
+		}
+		else
+		{
+			FinishQuickMatch(EQuickMatchResult::Failed, FBlueprintLobbyInfo());
+		}
+	});
+}
+
+void UOnlineSampleOnlineSubsystem::FinishQuickMatch(EQuickMatchResult Result, const FBlueprintLobbyInfo& LobbyInfo)
+{
+	// 상태를 먼저 비워서 이벤트 안에서 새 빠른 매칭을 시작할 수 있게 합니다.
+	++QuickMatchState.Serial;
+	QuickMatchState.bActive = false;
+	QuickMatchState.bJoinInFlight = false;
+	QuickMatchState.bCreateInFlight = false;
+	QuickMatchState.TierCandidates.Reset();
+	QuickMatchState.TriedLobbies.Reset();
+	GetGameInstance()->GetTimerManager().ClearTimer(QuickMatchState.DeadlineTimerHandle);
+
+	OnQuickMatchCompleteEvent.Broadcast(Result, LobbyInfo);
+	K2_OnQuickMatchCompleteEvent.Broadcast(Result, LobbyInfo);
 }
 
 void UOnlineSampleOnlineSubsystem::K2_LeaveLobby(ULocalPlayer* LocalPlayer, FBlueprintLobbyInfo LobbyInfo)
@@ -748,11 +3099,14 @@ void UOnlineSampleOnlineSubsystem::LeaveLobby(FPlatformUserId PlatformUserId, UE
 		LeaveLobbyParams.LobbyId = LobbyId;
 		LeaveLobbyParams.LocalAccountId = GetOnlineUserInfo(PlatformUserId)->AccountId;
 		
-		LobbiesInterface->LeaveLobby(MoveTemp(LeaveLobbyParams)).OnComplete([this](TOnlineResult<FLeaveLobby> LeaveLobbyResult)
+		LobbiesInterface->LeaveLobby(MoveTemp(LeaveLobbyParams)).OnComplete([this, bWasPrimaryLobby = IsPrimaryLobby(LobbyId)](TOnlineResult<FLeaveLobby> LeaveLobbyResult)
 		{
 			if(LeaveLobbyResult.IsOk())
 			{
-				LocalPlayerLobbyMemberInfo = FBlueprintLobbyMemberInfo();
+				if(bWasPrimaryLobby)
+				{
+					LocalPlayerLobbyMemberInfo = FBlueprintLobbyMemberInfo();
+				}
 				UE_LOG(LogTemp, Display, TEXT("Leave Lobby Complete"));
 			}
 			else
@@ -770,25 +3124,125 @@ void UOnlineSampleOnlineSubsystem::InitFriendsInfo(ULocalPlayer* LocalPlayer)
 	using namespace UE::Online;
 	
 	//델리게이트 바인드 순서가 문제가 될 수도 있으려나? (바인드 한 다음에 이번 GetFriends 호출이 아닌 저번 호출 결과때문에 델리게이트가 실행된다거나.)
-	FDelegateHandle FuncHandle = OnGetFriendsCompleteEvent.AddLambda([this, LocalPlayer, &FuncHandle](bool bSucceed)
+	// 핸들은 멤버에 둬야 람다가 끝난 스택 변수를 참조하지 않습니다. 이전 호출이 남긴 바인딩은 먼저 지웁니다.
+	OnGetFriendsCompleteEvent.Remove(InitFriendsInfoHandle);
+	InitFriendsInfoHandle = OnGetFriendsCompleteEvent.AddLambda([this, WeakLocalPlayer = TWeakObjectPtr<ULocalPlayer>(LocalPlayer)](bool bSucceed)
 	{
-		if(bSucceed)
+		OnGetFriendsCompleteEvent.Remove(InitFriendsInfoHandle);
+		InitFriendsInfoHandle.Reset();
+		
+		if(bSucceed && WeakLocalPlayer.IsValid())
 		{
-			for(auto& Tuple: FoundFriends)
-			{
-				const FBlueprintFriendInfo FriendInfo = Tuple.Value;
-				QueryPresence(LocalPlayer, FriendInfo.Friend->FriendId, true);	
-			}
-			
+			QueryFriendsPresence(WeakLocalPlayer.Get());
+		}
+	});
+	
+	GetFriends(LocalPlayer);
+
+	
+}
+
+void UOnlineSampleOnlineSubsystem::QueryFriendsPresence(ULocalPlayer* LocalPlayer)
+{
+	check(LocalPlayer);
+
+	if(!IsLoggedIn(LocalPlayer) || !OnlineServicesInfoInternal->PresenceInterface)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Local Player is not logged in"));
+		OnFriendsPresenceQueryCompleteEvent.Broadcast(false, 0, 0);
+		K2_OnFriendsPresenceQueryCompleteEvent.Broadcast(false, 0, 0);
+		return;
+	}
+
+	// 새 조회가 시작되면 이전 조회의 남은 응답은 버립니다.
+	++PresenceBatchState.Serial;
+	PresenceBatchState.LocalAccountId = GetOnlineUserInfo(LocalPlayer->GetPlatformUserId())->AccountId;
+	FriendRoster.GetAccountIds(PresenceBatchState.TargetAccountIds);
+	PresenceBatchState.NextIndex = 0;
+	PresenceBatchState.BatchesInFlight = 0;
+	PresenceBatchState.NumFailed = 0;
+	PresenceBatchState.bActive = true;
+
+	SendPresenceBatches();
+}
+
+void UOnlineSampleOnlineSubsystem::SendPresenceBatches()
+{
+	using namespace UE::Online;
+
+	if(!PresenceBatchState.bActive)
+	{
+		return;
+	}
+
+	IPresencePtr PresenceInterface = OnlineServicesInfoInternal->PresenceInterface;
+	const TArray<FAccountId>& TargetAccountIds = PresenceBatchState.TargetAccountIds;
+	const int32 BatchSize = FMath::Max(PresenceBatchSize, 1);
+
+	// 프레즌스 인터페이스가 사라졌으면 남은 친구는 모두 실패로 셉니다.
+	if(!PresenceInterface)
+	{
+		PresenceBatchState.NumFailed += TargetAccountIds.Num() - PresenceBatchState.NextIndex;
+		PresenceBatchState.NextIndex = TargetAccountIds.Num();
+	}
+	
+	while(PresenceBatchState.NextIndex < TargetAccountIds.Num() && PresenceBatchState.BatchesInFlight < FMath::Max(MaxPresenceBatchesInFlight, 1))
+	{
+		const int32 NumInBatch = FMath::Min(BatchSize, TargetAccountIds.Num() - PresenceBatchState.NextIndex);
+		
+		FBatchQueryPresence::Params BatchQueryPresenceParams;
+		BatchQueryPresenceParams.LocalAccountId = PresenceBatchState.LocalAccountId;
+		BatchQueryPresenceParams.TargetAccountIds.Append(TargetAccountIds.GetData() + PresenceBatchState.NextIndex, NumInBatch);
+		BatchQueryPresenceParams.bListenToChanges = true;
+		
+		PresenceBatchState.NextIndex += NumInBatch;
+		++PresenceBatchState.BatchesInFlight;
+		
+		PresenceInterface->BatchQueryPresence(MoveTemp(BatchQueryPresenceParams)).OnComplete([this, Serial = PresenceBatchState.Serial, NumInBatch]
+			(const TOnlineResult<FBatchQueryPresence>& BatchQueryPresenceResult)
+		{
+			HandleBatchQueryPresence(BatchQueryPresenceResult, Serial, NumInBatch);
+		});
+	}
+
+	if(PresenceBatchState.bActive && PresenceBatchState.NextIndex >= TargetAccountIds.Num() && PresenceBatchState.BatchesInFlight == 0)
+	{
+		PresenceBatchState.bActive = false;
+		
+		const int32 NumQueried = TargetAccountIds.Num();
+		const int32 NumFailed = PresenceBatchState.NumFailed;
+		UE_LOG(LogOnlineSampleOnlineSubsystem, Log, TEXT("Friends presence query complete : %d queried, %d failed"), NumQueried, NumFailed);
+		
+		OnFriendsPresenceQueryCompleteEvent.Broadcast(NumFailed == 0, NumQueried, NumFailed);
+		K2_OnFriendsPresenceQueryCompleteEvent.Broadcast(NumFailed == 0, NumQueried, NumFailed);
+	}
+}
+
+void UOnlineSampleOnlineSubsystem::HandleBatchQueryPresence(const UE::Online::TOnlineResult<UE::Online::FBatchQueryPresence>& BatchQueryPresenceResult, uint32 Serial, int32 BatchSize)
+{
+	using namespace UE::Online;
+
+	if(!PresenceBatchState.bActive || PresenceBatchState.Serial != Serial)
+	{
+		return;
+	}
+
+	--PresenceBatchState.BatchesInFlight;
+	if(BatchQueryPresenceResult.IsOk())
+	{
+		for(const TSharedRef<const FUserPresence>& Presence : BatchQueryPresenceResult.GetOkValue().Presences)
+		{
+			UpdateFriendPresence(*Presence);
 		}
+		UE_LOG(LogOnlineSampleOnlineSubsystem, Verbose, TEXT("Presence batch received : %d of %d"), BatchQueryPresenceResult.GetOkValue().Presences.Num(), BatchSize);
+	}
+	else
+	{
+		PresenceBatchState.NumFailed += BatchSize;
+		UE_LOG(LogOnlineSampleOnlineSubsystem, Warning, TEXT("Presence batch of %d failed : %s"), BatchSize, *BatchQueryPresenceResult.GetErrorValue().GetLogString());
+	}
 
-		//지울 필요가 있나?
-		OnGetFriendsCompleteEvent.Remove(FuncHandle);
-	});
-	
-	GetFriends(LocalPlayer);
-
-	
+	SendPresenceBatches();
 }
 
 void UOnlineSampleOnlineSubsystem::StartGameFromLobby(ULocalPlayer* LocalPlayer, FBlueprintLobbyInfo LobbyInfo)
@@ -802,24 +3256,94 @@ void UOnlineSampleOnlineSubsystem::StartGameFromLobby(ULocalPlayer* LocalPlayer,
 		return;
 	}
 
-	//
-	FString LevelPath = MyMap.ToSoftObjectPath().GetLongPackageName() + "?listen";
-	UE_LOG(LogTemp, Display, TEXT("LevelPath: %s"), *LevelPath);
-	if(MyMap.IsValid())
+	if(HostStartState.bActive)
+	{
+		UE_LOG(LogOnlineSampleOnlineSubsystem, Warning, TEXT("Start Game is already in progress"));
+		return;
+	}
+
+	// 마지막으로 만든 로비가 아니라 시작하는 로비의 MAPNAME을 따릅니다. 풀리지 않으면 블루프린트에서 넣어준 MyMap을 씁니다.
+	const FSoftObjectPath LobbyMapPath = ResolveLobbyMapPath(*LobbyInfo.Lobby);
+	const TSoftObjectPtr<UWorld> LevelToTravel = LobbyMapPath.IsNull() ? MyMap : TSoftObjectPtr<UWorld>(LobbyMapPath);
+	if(LevelToTravel.IsNull())
+	{
+		UE_LOG(LogTemp, Error, TEXT("Start Game Failed : No level to travel"));
+		OnHostStartCompleteEvent.Broadcast(false, FHostStartTimings());
+		K2_OnHostStartCompleteEvent.Broadcast(false, FHostStartTimings());
+		return;
+	}
+
+	const uint32 Serial = ++HostStartState.Serial;
+	HostStartState.TravelURL = LevelToTravel.ToSoftObjectPath().GetLongPackageName() + TEXT("?listen");
+	HostStartState.Timings = FHostStartTimings();
+	HostStartState.StartTime = FPlatformTime::Seconds();
+	HostStartState.bActive = true;
+	HostStartState.bMapLoaded = false;
+	HostStartState.bAnnounced = false;
+	UE_LOG(LogTemp, Display, TEXT("LevelPath: %s"), *HostStartState.TravelURL);
+
+	// 로비 속성 쓰기(네트워크)와 레벨 로드(디스크)를 동시에 시작합니다.
+	AdjustLobbyAfterStart(LocalPlayer, LobbyInfo, [this, Serial](bool bSucceeded)
+	{
+		if(!HostStartState.bActive || HostStartState.Serial != Serial)
+		{
+			return;
+		}
+		HostStartState.bAnnounced = true;
+		HostStartState.Timings.bAnnounceSucceeded = bSucceeded;
+		HostStartState.Timings.AnnounceSeconds = static_cast<float>(FPlatformTime::Seconds() - HostStartState.StartTime);
+		TryFinishHostStart();
+	});
+
+	if(LevelToTravel.IsValid())
 	{
-		GetWorld()->ServerTravel(LevelPath);
-		AdjustLobbyAfterStart(LocalPlayer, LobbyInfo);
+		HostStartState.bMapLoaded = true;
+		HostStartState.Timings.bMapWasPreloaded = true;
+		TryFinishHostStart();
 	}
-	else if(MyMap.IsPending())
+	else
 	{
-		FStreamableManager& Streamable = UAssetManager::GetStreamableManager();
-		Streamable.RequestAsyncLoad(MyMap.ToSoftObjectPath(), FStreamableDelegate::CreateLambda([this, LevelPath, LocalPlayer, LobbyInfo]()
+		UAssetManager::GetStreamableManager().RequestAsyncLoad(LevelToTravel.ToSoftObjectPath(), FStreamableDelegate::CreateWeakLambda(this, [this, Serial]()
 		{
-			GetWorld()->ServerTravel(LevelPath);
-			AdjustLobbyAfterStart(LocalPlayer, LobbyInfo);
-		}));
+			if(!HostStartState.bActive || HostStartState.Serial != Serial)
+			{
+				return;
+			}
+			HostStartState.bMapLoaded = true;
+			HostStartState.Timings.MapLoadSeconds = static_cast<float>(FPlatformTime::Seconds() - HostStartState.StartTime);
+			TryFinishHostStart();
+		}), FStreamableManager::AsyncLoadHighPriority);
 	}
-	//
+}
+
+void UOnlineSampleOnlineSubsystem::TryFinishHostStart()
+{
+	if(!HostStartState.bActive || !HostStartState.bMapLoaded || !HostStartState.bAnnounced)
+	{
+		return;
+	}
+
+	HostStartState.bActive = false;
+	HostStartState.Timings.TotalSeconds = static_cast<float>(FPlatformTime::Seconds() - HostStartState.StartTime);
+	if(!HostStartState.Timings.bAnnounceSucceeded)
+	{
+		UE_LOG(LogOnlineSampleOnlineSubsystem, Warning, TEXT("MATCHSTATE=Starting was not written, travelling anyway"));
+	}
+	UE_LOG(LogOnlineSampleOnlineSubsystem, Log, TEXT("Host start : load %.3fs, announce %.3fs, total %.3fs"),
+		HostStartState.Timings.MapLoadSeconds, HostStartState.Timings.AnnounceSeconds, HostStartState.Timings.TotalSeconds);
+
+	// 이미 클라이언트를 받고 있으면 연결을 끊지 않고 데려갑니다. 독립 실행 중이면 ?listen으로 새로 엽니다.
+	UWorld* World = GetWorld();
+	HostStartState.Timings.bSeamlessTravel = bEnableSeamlessTravel && World->GetNetMode() == NM_ListenServer;
+	if(AGameModeBase* GameMode = World->GetAuthGameMode())
+	{
+		GameMode->bUseSeamlessTravel = HostStartState.Timings.bSeamlessTravel;
+	}
+	
+	World->ServerTravel(HostStartState.TravelURL);
+	
+	OnHostStartCompleteEvent.Broadcast(true, HostStartState.Timings);
+	K2_OnHostStartCompleteEvent.Broadcast(true, HostStartState.Timings);
 }
 
 void UOnlineSampleOnlineSubsystem::TravelToLobby(ULocalPlayer* LocalPlayer, FBlueprintLobbyInfo LobbyInfo)
@@ -837,6 +3361,15 @@ void UOnlineSampleOnlineSubsystem::TravelToLobby(ULocalPlayer* LocalPlayer, FBlu
 		if(Result.IsOk())
 		{
 			UE_LOG(LogTemp, Warning, TEXT("ResolvedConectString URL for Client Travel : %s |And| %s"), *Result.GetOkValue().ResolvedConnectString, *MyMap.ToSoftObjectPath().GetLongPackageName());
+
+			// 이미 이 호스트에 붙어 있으면 다시 접속하지 않습니다. 이후 이동은 호스트의 심리스 트래블을 따라갑니다.
+			const UWorld* World = GetWorld();
+			const FURL ConnectURL(nullptr, *Result.GetOkValue().ResolvedConnectString, TRAVEL_Absolute);
+			if(World && World->GetNetMode() == NM_Client && World->URL.Host == ConnectURL.Host && World->URL.Port == ConnectURL.Port)
+			{
+				UE_LOG(LogOnlineSampleOnlineSubsystem, Log, TEXT("Already connected to lobby host, skipping ClientTravel"));
+				return;
+			}
 			
 			LocalPlayer->PlayerController->ClientTravel(Result.GetOkValue().ResolvedConnectString, TRAVEL_Absolute);
 		}else
@@ -936,37 +3469,137 @@ void UOnlineSampleOnlineSubsystem::GetUserInfo(ULocalPlayer* LocalPlayer, TArray
 		return;
 	}
 
-	if(IUserInfoPtr UserInfoInterface = OnlineServicesInfoInternal->UserInfoInterface)
+	// 캐시에 있는 계정은 바로 FoundUsers에 반영되고, 나머지는 다음 프레임에 한 번에 묻습니다.
+	for(const FAccountId& TargetUser : TargetUsers)
+	{
+		ResolveUserInfo(LocalPlayer, TargetUser).Then([this](TFuture<FBlueprintUserInfo> Future)
+		{
+			const FBlueprintUserInfo UserInfo = Future.Get();
+			if(UserInfo.UserId != -1 && !FoundUsers.ContainsByPredicate([&UserInfo](const FBlueprintUserInfo& FoundUser) { return FoundUser.UserId == UserInfo.UserId; }))
+			{
+				FoundUsers.Add(UserInfo);
+			}
+		});
+	}
+}
+
+TFuture<FBlueprintUserInfo> UOnlineSampleOnlineSubsystem::ResolveUserInfo(ULocalPlayer* LocalPlayer, const UE::Online::FAccountId& TargetUser)
+{
+	using namespace UE::Online;
+	check(LocalPlayer);
+
+	if(!IsLoggedIn(LocalPlayer) || !OnlineServicesInfoInternal->UserInfoInterface)
+	{
+		return MakeFulfilledPromise<FBlueprintUserInfo>().GetFuture();
+	}
+
+	FUserInfoCacheEntry& CacheEntry = UserInfoCache.FindOrAdd(TargetUser);
+	const bool bFresh = CacheEntry.FetchedTime > 0.0 && FPlatformTime::Seconds() - CacheEntry.FetchedTime <= UserInfoCacheTTLSeconds;
+	if(bFresh)
+	{
+		return MakeFulfilledPromise<FBlueprintUserInfo>(CacheEntry.Info).GetFuture();
+	}
+
+	TFuture<FBlueprintUserInfo> Future = CacheEntry.Waiters.Emplace_GetRef().GetFuture();
+	if(CacheEntry.bQueryInFlight)
+	{
+		return Future;
+	}
+
+	// 다른 호출자가 같은 프레임에 요청한 계정과 묶습니다.
+	CacheEntry.bQueryInFlight = true;
+	PendingUserInfoQueries.FindOrAdd(GetOnlineUserInfo(LocalPlayer->GetPlatformUserId())->AccountId).Add(TargetUser);
+
+	FTimerManager& TimerManager = GetGameInstance()->GetTimerManager();
+	if(!TimerManager.TimerExists(UserInfoFlushTimerHandle))
+	{
+		UserInfoFlushTimerHandle = TimerManager.SetTimerForNextTick(this, &ThisClass::FlushUserInfoQueries);
+	}
+	
+	return Future;
+}
+
+void UOnlineSampleOnlineSubsystem::FlushUserInfoQueries()
+{
+	using namespace UE::Online;
+
+	GetGameInstance()->GetTimerManager().ClearTimer(UserInfoFlushTimerHandle);
+	
+	TMap<FAccountId, TArray<FAccountId>> Queries = MoveTemp(PendingUserInfoQueries);
+	PendingUserInfoQueries.Reset();
+
+	// 만료되었고 아무도 다시 묻지 않는 항목은 지웁니다. 갱신 중인 항목은 실패했을 때 돌려줄 값으로 남깁니다.
+	const double Now = FPlatformTime::Seconds();
+	for(auto It = UserInfoCache.CreateIterator(); It; ++It)
+	{
+		if(!It.Value().bQueryInFlight && Now - It.Value().FetchedTime > UserInfoCacheTTLSeconds)
+		{
+			It.RemoveCurrent();
+		}
+	}
+
+	IUserInfoPtr UserInfoInterface = OnlineServicesInfoInternal->UserInfoInterface;
+	const int32 BatchSize = FMath::Max(UserInfoQueryBatchSize, 1);
+	
+	for(TPair<FAccountId, TArray<FAccountId>>& Query : Queries)
 	{
-		FoundUsers.Empty();
+		const FAccountId LocalAccountId = Query.Key;
+		const TArray<FAccountId>& TargetUsers = Query.Value;
 		
-		FQueryUserInfo::Params QueryUserInfoParam;
-		QueryUserInfoParam.AccountIds.Insert(TargetUsers, 0);
-		QueryUserInfoParam.LocalAccountId = GetOnlineUserInfo(LocalPlayer->GetPlatformUserId())->AccountId;
-		UserInfoInterface->QueryUserInfo(MoveTemp(QueryUserInfoParam)).OnComplete([this, LocalPlayer, UserInfoInterface, TargetUsers]
-			(TOnlineResult<FQueryUserInfo> QueryUserInfoResult)
+		for(int32 First = 0; First < TargetUsers.Num(); First += BatchSize)
 		{
-			if(QueryUserInfoResult.IsOk())
+			TArray<FAccountId> BatchTargets(TargetUsers.GetData() + First, FMath::Min(BatchSize, TargetUsers.Num() - First));
+			if(!UserInfoInterface)
 			{
-				for(const FAccountId TargetId : TargetUsers)
+				for(const FAccountId& TargetUser : BatchTargets)
 				{
-					FGetUserInfo::Params GetUserInfoParams;
-					GetUserInfoParams.AccountId = TargetId;
-					GetUserInfoParams.LocalAccountId = GetOnlineUserInfo(LocalPlayer->GetPlatformUserId())->AccountId;
-					TOnlineResult<FGetUserInfo> GetUserInfoResult = UserInfoInterface->GetUserInfo(MoveTemp(GetUserInfoParams));
-					HandleGetUserInfo(GetUserInfoResult);
+					HandleGetUserInfo(TOnlineResult<FGetUserInfo>(Errors::NotImplemented()), TargetUser);
 				}
-				
-			}
-			else
-			{
-				UE_LOG(LogTemp, Error, TEXT("Query User Info Failed : %s"), *QueryUserInfoResult.GetErrorValue().GetLogString());
+				continue;
 			}
 			
-		});
-		
-		
-		
+			FQueryUserInfo::Params QueryUserInfoParam;
+			QueryUserInfoParam.AccountIds = BatchTargets;
+			QueryUserInfoParam.LocalAccountId = LocalAccountId;
+			UserInfoInterface->QueryUserInfo(MoveTemp(QueryUserInfoParam)).OnComplete([this, UserInfoInterface, LocalAccountId, BatchTargets = MoveTemp(BatchTargets)]
+				(const TOnlineResult<FQueryUserInfo>& QueryUserInfoResult)
+			{
+				if(!QueryUserInfoResult.IsOk())
+				{
+					UE_LOG(LogTemp, Error, TEXT("Query User Info Failed : %s"), *QueryUserInfoResult.GetErrorValue().GetLogString());
+				}
+				
+				// QueryUserInfo는 결과를 서비스 캐시에 채우기만 하므로, 이번에 물은 계정만 한 번씩 꺼냅니다.
+				for(const FAccountId& TargetUser : BatchTargets)
+				{
+					if(!QueryUserInfoResult.IsOk())
+					{
+						HandleGetUserInfo(TOnlineResult<FGetUserInfo>(QueryUserInfoResult.GetErrorValue()), TargetUser);
+						continue;
+					}
+					
+					FGetUserInfo::Params GetUserInfoParams;
+					GetUserInfoParams.AccountId = TargetUser;
+					GetUserInfoParams.LocalAccountId = LocalAccountId;
+					HandleGetUserInfo(UserInfoInterface->GetUserInfo(MoveTemp(GetUserInfoParams)), TargetUser);
+				}
+			});
+		}
+	}
+}
+
+void UOnlineSampleOnlineSubsystem::InvalidateUserInfoCache()
+{
+	for(auto It = UserInfoCache.CreateIterator(); It; ++It)
+	{
+		if(It.Value().bQueryInFlight)
+		{
+			It.Value().FetchedTime = 0.0;
+		}
+		else
+		{
+			It.RemoveCurrent();
+		}
 	}
 }
 
@@ -987,57 +3620,185 @@ void UOnlineSampleOnlineSubsystem::Login(FPlatformUserId PlatformUserId)
 			if (!OnlineUserInfos.Contains(PlatformUserId))
 			{
 				const TSharedRef<FAccountInfo> AccountInfo =  LocalUserSearchResult.GetOkValue().AccountInfo;
-				UOnlineUserInfo* NewUser = CreateAndRegisterUserInfo(AccountInfo->AccountId.GetHandle(), PlatformUserId, AccountInfo->AccountId, AccountInfo->AccountId.GetOnlineServicesType());
+				UOnlineUserInfo* NewUser = CreateAndRegisterUserInfo(GetLocalUserIndex(PlatformUserId), PlatformUserId, AccountInfo->AccountId, AccountInfo->AccountId.GetOnlineServicesType());
  
 				UE_LOG(LogOnlineSampleOnlineSubsystem, Warning, TEXT("Local User Registered: %s"), *(NewUser->DebugInfoToString()));
 			}
 
-			OnLoginCompleteEvent.Broadcast(LocalUserSearchResult.IsOk());
-			K2_OnLoginCompleteEvent.Broadcast(LocalUserSearchResult.IsOk());
-			
+			LoginPipelines.Add(PlatformUserId).StartTime = FPlatformTime::Seconds();
+			FinishLogin(PlatformUserId, true, EBlueprintLoginMethod::AlreadyLoggedIn);
 			return;
 		}
-		
-		
-		FAuthLogin::Params LoginParams;
-		//LoginParams.CredentialsId = FString("localhost:8081");
-		LoginParams.PlatformUserId = PlatformUserId;
-		
-		//LoginParams.CredentialsToken.Emplace<FString>("TestCredentialName");
-		LoginParams.CredentialsType = LoginCredentialsType::AccountPortal;
-		//LoginParams.CredentialsType = LoginCredentialsType::Developer;
-		//LoginParams.
-		
-		OnlineServicesInfoInternal->AuthInterface->Login(MoveTemp(LoginParams)).OnComplete([this, PlatformUserId](const UE::Online::TOnlineResult<UE::Online::FAuthLogin>& Result)
+
+		// 같은 유저의 로그인이 이미 진행 중이면 그 결과를 기다립니다.
+		if(LoginPipelines.Contains(PlatformUserId))
+		{
+			return;
+		}
+		LoginPipelines.Add(PlatformUserId).StartTime = FPlatformTime::Seconds();
+
+		// SDK가 보관한 리프레시 토큰이 있는지는 시도해 봐야 알 수 있으므로 항상 조용히 먼저 시도합니다.
+		if(bEnablePersistentLogin)
+		{
+			UE_LOG(LogOnlineSampleOnlineSubsystem, Log, TEXT("Trying persistent login"));
+			SendLoginStage(PlatformUserId, LoginCredentialsType::PersistentAuth);
+		}
+		else
+		{
+			SendLoginStage(PlatformUserId, LoginCredentialsType::AccountPortal);
+		}
+	}
+	else
+	{
+		FinishLogin(PlatformUserId, false, EBlueprintLoginMethod::None);
+	}
+}
+
+void UOnlineSampleOnlineSubsystem::LoginAllLocalPlayers()
+{
+	if(MultiLoginState.bActive)
+	{
+		return;
+	}
+
+	TArray<FPlatformUserId> PlatformUserIds;
+	for(const ULocalPlayer* LocalPlayer : GetGameInstance()->GetLocalPlayers())
 	{
-		if(Result.IsOk()) 
+		if(LocalPlayer && LocalPlayer->GetPlatformUserId().IsValid())
 		{
-			const TSharedRef<UE::Online::FAccountInfo> AccountInfo = Result.GetOkValue().AccountInfo;
-			
-			if (!OnlineUserInfos.Contains(AccountInfo->PlatformUserId))
-			{
-				TObjectPtr<UOnlineUserInfo> NewUser = CreateAndRegisterUserInfo(AccountInfo->AccountId.GetHandle(), PlatformUserId, AccountInfo->AccountId, AccountInfo->AccountId.GetOnlineServicesType());
-				
-				UE_LOG(LogOnlineSampleOnlineSubsystem, Warning, TEXT("Local User Registered: %s"), *(NewUser->DebugInfoToString()));
-			}
-			else
-			{
-				UE_LOG(LogOnlineSampleOnlineSubsystem, Error, TEXT("Local User with platform user id %d already registered."), PlatformUserId.GetInternalId());
-			}
+			PlatformUserIds.AddUnique(LocalPlayer->GetPlatformUserId());
+		}
+	}
+	if(PlatformUserIds.IsEmpty())
+	{
+		OnAllLocalPlayersLoginCompleteEvent.Broadcast(false, 0, 0);
+		K2_OnAllLocalPlayersLoginCompleteEvent.Broadcast(false, 0, 0);
+		return;
+	}
+
+	// 이미 로그인된 유저는 Login 안에서 바로 끝나므로, 대기 목록을 다 채운 다음에 보냅니다.
+	MultiLoginState = FMultiLoginState();
+	MultiLoginState.bActive = true;
+	MultiLoginState.PendingUsers.Append(PlatformUserIds);
+	for(const FPlatformUserId PlatformUserId : PlatformUserIds)
+	{
+		UE_LOG(LogOnlineSampleOnlineSubsystem, Log, TEXT("Logging in local user %d"), PlatformUserId.GetInternalId());
+		Login(PlatformUserId);
+	}
+}
+
+void UOnlineSampleOnlineSubsystem::HandleMultiLoginResult(FPlatformUserId PlatformUserId, bool bSucceeded)
+{
+	if(!MultiLoginState.bActive || MultiLoginState.PendingUsers.Remove(PlatformUserId) == 0)
+	{
+		return;
+	}
+	++(bSucceeded ? MultiLoginState.NumSucceeded : MultiLoginState.NumFailed);
+	if(!MultiLoginState.PendingUsers.IsEmpty())
+	{
+		return;
+	}
+
+	const int32 NumSucceeded = MultiLoginState.NumSucceeded;
+	const int32 NumFailed = MultiLoginState.NumFailed;
+	MultiLoginState = FMultiLoginState();
+
+	UE_LOG(LogOnlineSampleOnlineSubsystem, Log, TEXT("All local players login finished: %d succeeded, %d failed"), NumSucceeded, NumFailed);
+	OnAllLocalPlayersLoginCompleteEvent.Broadcast(NumFailed == 0, NumSucceeded, NumFailed);
+	K2_OnAllLocalPlayersLoginCompleteEvent.Broadcast(NumFailed == 0, NumSucceeded, NumFailed);
+}
+
+void UOnlineSampleOnlineSubsystem::SendLoginStage(FPlatformUserId PlatformUserId, FName CredentialsType)
+{
+	using namespace UE::Online;
+
+	FLoginPipelineState* Pipeline = LoginPipelines.Find(PlatformUserId);
+	IAuthPtr AuthInterface = OnlineServicesInfoInternal->AuthInterface;
+	if(!Pipeline || !AuthInterface)
+	{
+		FinishLogin(PlatformUserId, false, EBlueprintLoginMethod::None);
+		return;
+	}
+	Pipeline->StageStartTime = FPlatformTime::Seconds();
+	
+	FAuthLogin::Params LoginParams;
+	//LoginParams.CredentialsId = FString("localhost:8081");
+	LoginParams.PlatformUserId = PlatformUserId;
+	
+	//LoginParams.CredentialsToken.Emplace<FString>("TestCredentialName");
+	LoginParams.CredentialsType = CredentialsType;
+	//LoginParams.CredentialsType = LoginCredentialsType::Developer;
+	
+	AuthInterface->Login(MoveTemp(LoginParams)).OnComplete([this, PlatformUserId, CredentialsType](const UE::Online::TOnlineResult<UE::Online::FAuthLogin>& Result)
+	{
+		HandleLoginStage(Result, PlatformUserId, CredentialsType);
+	});
+}
+
+void UOnlineSampleOnlineSubsystem::HandleLoginStage(const UE::Online::TOnlineResult<UE::Online::FAuthLogin>& LoginResult, FPlatformUserId PlatformUserId, FName CredentialsType)
+{
+	using namespace UE::Online;
+
+	FLoginPipelineState* Pipeline = LoginPipelines.Find(PlatformUserId);
+	if(!Pipeline)
+	{
+		return;
+	}
+	
+	const bool bPersistentAuth = CredentialsType == LoginCredentialsType::PersistentAuth;
+	const float StageSeconds = static_cast<float>(FPlatformTime::Seconds() - Pipeline->StageStartTime);
+	(bPersistentAuth ? Pipeline->Timings.PersistentAuthSeconds : Pipeline->Timings.AccountPortalSeconds) = StageSeconds;
+	
+	if(LoginResult.IsOk()) 
+	{
+		const TSharedRef<UE::Online::FAccountInfo> AccountInfo = LoginResult.GetOkValue().AccountInfo;
+		
+		if (!OnlineUserInfos.Contains(AccountInfo->PlatformUserId))
+		{
+			TObjectPtr<UOnlineUserInfo> NewUser = CreateAndRegisterUserInfo(GetLocalUserIndex(PlatformUserId), PlatformUserId, AccountInfo->AccountId, AccountInfo->AccountId.GetOnlineServicesType());
 			
+			UE_LOG(LogOnlineSampleOnlineSubsystem, Warning, TEXT("Local User Registered: %s"), *(NewUser->DebugInfoToString()));
 		}
 		else
 		{
-			FOnlineError Error = Result.GetErrorValue();
-			// 이제 오류를 처리할 수 있습니다.
-			UE_LOG(LogOnlineSampleOnlineSubsystem, Error, TEXT("Login Error: %s"), *Error.GetLogString());
+			UE_LOG(LogOnlineSampleOnlineSubsystem, Error, TEXT("Local User with platform user id %d already registered."), PlatformUserId.GetInternalId());
 		}
 
-			OnLoginCompleteEvent.Broadcast(Result.IsOk());
-			K2_OnLoginCompleteEvent.Broadcast(Result.IsOk());
-	});
+		FinishLogin(PlatformUserId, true, bPersistentAuth ? EBlueprintLoginMethod::PersistentAuth : EBlueprintLoginMethod::AccountPortal);
+		return;
 	}
 	
+	UE_LOG(LogOnlineSampleOnlineSubsystem, Error, TEXT("Login Error (%s): %s"), *CredentialsType.ToString(), *LoginResult.GetErrorValue().GetLogString());
+
+	if(bPersistentAuth)
+	{
+		// 저장된 자격 증명이 없거나 만료되었으므로 포털로 넘어갑니다.
+		SendLoginStage(PlatformUserId, LoginCredentialsType::AccountPortal);
+		return;
+	}
+	FinishLogin(PlatformUserId, false, EBlueprintLoginMethod::None);
+}
+
+void UOnlineSampleOnlineSubsystem::FinishLogin(FPlatformUserId PlatformUserId, bool bSucceeded, EBlueprintLoginMethod Method)
+{
+	FLoginTimings Timings;
+	FLoginPipelineState Pipeline;
+	if(LoginPipelines.RemoveAndCopyValue(PlatformUserId, Pipeline))
+	{
+		Timings = Pipeline.Timings;
+		Timings.TotalSeconds = static_cast<float>(FPlatformTime::Seconds() - Pipeline.StartTime);
+	}
+	Timings.Method = Method;
+
+	UE_LOG(LogOnlineSampleOnlineSubsystem, Log, TEXT("Login %s in %.3fs (PersistentAuth %.3fs, AccountPortal %.3fs)"),
+		bSucceeded ? TEXT("Succeeded") : TEXT("Failed"), Timings.TotalSeconds, Timings.PersistentAuthSeconds, Timings.AccountPortalSeconds);
+
+	OnLoginCompleteEvent.Broadcast(bSucceeded);
+	K2_OnLoginCompleteEvent.Broadcast(bSucceeded);
+	OnLoginTimingsReportedEvent.Broadcast(bSucceeded, Timings);
+	K2_OnLoginTimingsReportedEvent.Broadcast(bSucceeded, Timings);
+
+	HandleMultiLoginResult(PlatformUserId, bSucceeded);
 }
 
 void UOnlineSampleOnlineSubsystem::Logout()
@@ -1052,10 +3813,13 @@ void UOnlineSampleOnlineSubsystem::Logout()
 			
 			const UOnlineUserInfo* UserInfo = Tuple.Value;
 
-			//입장한 로비가 있다면 떠나기.
-			if(JoinedLobby.Lobby.IsValid())
+			//입장한 로비가 있다면 떠나기. 이 유저가 멤버인 로비만 떠납니다.
+			for(const FLobbyStateEntry& Entry : LobbyStates.Entries)
 			{
-				LeaveLobby(UserInfo->PlatformUserId, JoinedLobby.Lobby.Get()->LobbyId);
+				if(Entry.Info.Lobby->Members.Contains(UserInfo->AccountId))
+				{
+					LeaveLobby(UserInfo->PlatformUserId, Entry.Info.Lobby->LobbyId);
+				}
 			}
 			
 			FAuthLogout::Params LogoutParams;
@@ -1074,6 +3838,39 @@ void UOnlineSampleOnlineSubsystem::Logout()
 	}
 }
 
+int32 UOnlineSampleOnlineSubsystem::GetLocalUserIndex(FPlatformUserId PlatformUserId) const
+{
+	return GetGameInstance()->GetLocalPlayers().IndexOfByPredicate([PlatformUserId](const ULocalPlayer* LocalPlayer)
+	{
+		return LocalPlayer && LocalPlayer->GetPlatformUserId() == PlatformUserId;
+	});
+}
+
+ULocalPlayer* UOnlineSampleOnlineSubsystem::FindLocalPlayerByAccountId(UE::Online::FAccountId AccountId) const
+{
+	for(const TPair<int32, TObjectPtr<const UOnlineUserInfo>>& Tuple : OnlineUserInfos)
+	{
+		if(Tuple.Value && Tuple.Value->AccountId == AccountId)
+		{
+			return GetGameInstance()->FindLocalPlayerFromPlatformUserId(Tuple.Value->PlatformUserId);
+		}
+	}
+	return nullptr;
+}
+
+ULocalPlayer* UOnlineSampleOnlineSubsystem::FindLocalPlayerInLobby(const UE::Online::FLobby& Lobby) const
+{
+	for(ULocalPlayer* LocalPlayer : GetGameInstance()->GetLocalPlayers())
+	{
+		const TObjectPtr<const UOnlineUserInfo>* UserInfo = LocalPlayer ? OnlineUserInfos.Find(LocalPlayer->GetPlatformUserId().GetInternalId()) : nullptr;
+		if(UserInfo && *UserInfo && Lobby.Members.Contains((*UserInfo)->AccountId))
+		{
+			return LocalPlayer;
+		}
+	}
+	return nullptr;
+}
+
 bool UOnlineSampleOnlineSubsystem::IsLoggedIn(ULocalPlayer* LocalPlayer)
 {
 	if(OnlineUserInfos.Contains(LocalPlayer->GetPlatformUserId()))
@@ -1094,17 +3891,27 @@ void UOnlineSampleOnlineSubsystem::K2_FindSessions(APlayerController* PlayerCont
 	using namespace UE::Online;
 	check(PlayerController);
 
+	// LAN은 백엔드를 거치지 않는 비컨으로 찾습니다.
+	if(bUseLan)
+	{
+		FindLanSessions(MaxResults);
+		return;
+	}
+
 	if(const UOnlineUserInfo* OnlineUserInfo =  GetOnlineUserInfo(PlayerController->GetPlatformUserId()))
 	{
 		if(UE::Online::IAuthPtr AuthInterface = OnlineServicesInfoInternal->AuthInterface)
 		{
 			if(!AuthInterface->IsLoggedIn(OnlineUserInfo->AccountId))
 			{
+				UE_LOG(LogTemp, Warning, TEXT("Local Player is not logged in"));
+				FinishFindSessions(false);
 				return;
 			}
 		}
 		else
 		{
+			FinishFindSessions(false);
 			return;
 		}
 		
@@ -1116,6 +3923,10 @@ void UOnlineSampleOnlineSubsystem::K2_FindSessions(APlayerController* PlayerCont
 
 		FindSessions(FindSessionsParams);
 	}
+	else
+	{
+		FinishFindSessions(false);
+	}
 }
 
 /// <summary>
@@ -1194,4 +4005,53 @@ const FString UOnlineUserInfo::DebugInfoToString()
 	FormatArgs.Add(FStringFormatArg(PlatformId));
 	FormatArgs.Add(FStringFormatArg(AccId));
 	return FString::Format(TEXT("LocalUserNumber: {0}, PlatformUserId: {1}, AccountId: {2}"), FormatArgs);
-}
\ No newline at end of file
+}
+
+FBlueprintSessionInfo::FBlueprintSessionInfo(const UE::Online::ISession& Session)
+	: SessionId(Session.GetSessionId())
+{
+	using namespace UE::Online;
+
+	const FSessionSettings SessionSettings = Session.GetSessionSettings();
+	
+	SessionInfoString = ToLogString(SessionId);
+	OwnerId = Session.GetOwnerAccountId().GetHandle();
+	MaxPlayers = static_cast<int32>(SessionSettings.NumMaxConnections);
+	NumOpenSlots = static_cast<int32>(Session.GetNumOpenConnections());
+	NumPlayers = FMath::Max(MaxPlayers - NumOpenSlots, 0);
+	bIsJoinable = Session.IsJoinable();
+	SchemaName = SessionSettings.SchemaName;
+	
+	Attributes.Reserve(SessionSettings.CustomSettings.Num());
+	for(const TPair<FSchemaAttributeId, FCustomSessionSetting>& CustomSetting : SessionSettings.CustomSettings)
+	{
+		Attributes.Add(CustomSetting.Key, FOnlineSampleLobbySchema::VariantToString(CustomSetting.Value.Data));
+	}
+}
+
+FBlueprintPresenceInfo::FBlueprintPresenceInfo(const UE::Online::FUserPresence& InPresence)
+	: AccountHandle(InPresence.AccountId.GetHandle())
+	, StatusString(InPresence.StatusString)
+	, RichPresenceString(InPresence.RichPresenceString)
+{
+	using namespace UE::Online;
+
+	switch(InPresence.Status)
+	{
+	case EUserPresenceStatus::Offline:		Status = EBlueprintPresenceStatus::Offline; break;
+	case EUserPresenceStatus::Online:		Status = EBlueprintPresenceStatus::Online; break;
+	case EUserPresenceStatus::Away:			Status = EBlueprintPresenceStatus::Away; break;
+	case EUserPresenceStatus::ExtendedAway:	Status = EBlueprintPresenceStatus::ExtendedAway; break;
+	case EUserPresenceStatus::DoNotDisturb:	Status = EBlueprintPresenceStatus::DoNotDisturb; break;
+	default:								Status = EBlueprintPresenceStatus::Unknown; break;
+	}
+
+	switch(InPresence.Joinability)
+	{
+	case EUserPresenceJoinability::Public:		Joinability = EBlueprintPresenceJoinability::Public; break;
+	case EUserPresenceJoinability::FriendsOnly:	Joinability = EBlueprintPresenceJoinability::FriendsOnly; break;
+	case EUserPresenceJoinability::InviteOnly:	Joinability = EBlueprintPresenceJoinability::InviteOnly; break;
+	case EUserPresenceJoinability::Private:		Joinability = EBlueprintPresenceJoinability::Private; break;
+	default:									Joinability = EBlueprintPresenceJoinability::Unknown; break;
+	}
+}
@@ -3,6 +3,7 @@
 #pragma once
 
 #include "CoreMinimal.h"
+#include "Async/Future.h"
 #include "Online/Lobbies.h"
 #include "Online/OnlineAsyncOpHandle.h"
 
@@ -12,9 +13,14 @@
 #include "Online/Sessions.h"
 #include "Online/Social.h"
 #include "Online/UserInfo.h"
+#include "OnlineSampleFriendRoster.h"
+#include "OnlineSampleLanBeacon.h"
+#include "OnlineSampleLobbyQuery.h"
+#include "OnlineSampleQosProbe.h"
 #include "Subsystems/GameInstanceSubsystem.h"
 #include "OnlineSampleOnlineSubsystem.generated.h"
 
+struct FStreamableHandle;
 
 namespace UE::Online
 {
@@ -22,6 +28,7 @@ namespace UE::Online
 	
 	struct FLobbyMemberLeft;
 	struct FLobbyMemberJoined;
+	struct FLobbyMemberAttributesChanged;
 
 	struct FLobby;
 	struct FCreateLobby;
@@ -31,16 +38,50 @@ namespace UE::Online
 class UOnlineUserInfo;
 DECLARE_LOG_CATEGORY_EXTERN(LogOnlineSampleOnlineSubsystem, Log, All);
 
+/** 찾은 세션 하나의 요약입니다. ISession을 붙잡지 않고 목록에 필요한 값만 복사해 둡니다 */
 USTRUCT(BlueprintType)
 struct FBlueprintSessionInfo
 {
 	GENERATED_BODY()
+
+	FBlueprintSessionInfo(){};
+	explicit FBlueprintSessionInfo(const UE::Online::ISession& Session);
 	
+	/** 세션 ID의 로그 문자열 */
 	UPROPERTY(BlueprintReadOnly)
 	FString SessionInfoString;
 
+	UPROPERTY(BlueprintReadOnly)
+	int32 OwnerId = -1;
+
+	UPROPERTY(BlueprintReadOnly)
+	int32 MaxPlayers = 0;
+
+	UPROPERTY(BlueprintReadOnly)
+	int32 NumPlayers = 0;
+
+	UPROPERTY(BlueprintReadOnly)
+	int32 NumOpenSlots = 0;
+
+	UPROPERTY(BlueprintReadOnly)
+	bool bIsJoinable = false;
+
+	UPROPERTY(BlueprintReadOnly)
+	FName SchemaName;
+
+	/** 세션 설정의 커스텀 속성. 값은 문자열로 바꿔 둡니다 */
+	UPROPERTY(BlueprintReadOnly)
+	TMap<FName, FString> Attributes;
+
+	/** LAN 비컨으로 찾은 세션인지. LAN 세션은 SessionId 없이 HostAddress로 접속합니다 */
+	UPROPERTY(BlueprintReadOnly)
+	bool bIsLan = false;
+
+	/** LAN 세션의 "IP:Port" 접속 주소 */
+	UPROPERTY(BlueprintReadOnly)
+	FString HostAddress;
+
 	UE::Online::FOnlineSessionId SessionId;
-	
 };
 
 USTRUCT(BlueprintType)
@@ -58,6 +99,39 @@ struct FCreateLobbyRequest
 	TSoftObjectPtr<UWorld> LevelToTravel;
 };
 
+/**
+ * 빠른 매칭 요청입니다.
+ *		SearchTiers의 검색을 한꺼번에 보내고, 먼저 돌아온 결과 중 들어갈 수 있는 로비에 참가합니다.
+ *		DeadlineSeconds 안에 참가하지 못하면 FallbackLobby로 새 로비를 만듭니다
+ */
+USTRUCT(BlueprintType)
+struct FQuickMatchRequest
+{
+	GENERATED_BODY()
+
+	/** 엄격한 조건부터 느슨한 조건 순서. 다음 후보를 고를 때 앞쪽 조건의 후보를 먼저 봅니다. 비어 있으면 조건 없이 검색합니다 */
+	UPROPERTY(BlueprintReadWrite)
+	TArray<FBlueprintLobbySearchQuery> SearchTiers;
+
+	UPROPERTY(BlueprintReadWrite)
+	float DeadlineSeconds = 5.f;
+
+	UPROPERTY(BlueprintReadWrite)
+	bool bCreateLobbyOnTimeout = true;
+
+	UPROPERTY(BlueprintReadWrite)
+	FCreateLobbyRequest FallbackLobby;
+};
+
+UENUM(BlueprintType)
+enum class EQuickMatchResult : uint8
+{
+	Joined,
+	Created,
+	Cancelled,
+	Failed
+};
+
 
 USTRUCT(BlueprintType)
 struct FBlueprintLobbyInfo
@@ -66,8 +140,9 @@ struct FBlueprintLobbyInfo
 
 	FBlueprintLobbyInfo(){};
 	FBlueprintLobbyInfo(TSharedPtr<const UE::Online::FLobby> InLobby) : Lobby(InLobby), MaxMembers(InLobby.Get()->MaxMembers)
-	, LobbyName(InLobby.Get()->LocalName)
+	, LobbyName(InLobby.Get()->LocalName), LobbyId(InLobby.Get()->LobbyId.GetHandle())
 	{
+		Members.Reserve(InLobby.Get()->Members.Num());
 		for(auto& Member : InLobby.Get()->Members)
 		{
 			Members.Add(Member.Key.GetHandle());
@@ -84,6 +159,138 @@ struct FBlueprintLobbyInfo
 
 	UPROPERTY(BlueprintReadOnly)
 	FName LobbyName;
+
+	UPROPERTY(BlueprintReadOnly)
+	int32 LobbyId = -1;
+
+	/** QoS 프로브로 잰 호스트 왕복 시간(ms). 재지 않았거나 응답이 없으면 -1 */
+	UPROPERTY(BlueprintReadOnly)
+	float PingMs = -1.f;
+};
+
+/** 로비 참가 시도 한 번의 기록입니다 */
+USTRUCT(BlueprintType)
+struct FBlueprintLobbyJoinAttempt
+{
+	GENERATED_BODY()
+
+	UPROPERTY(BlueprintReadOnly)
+	int32 LobbyId = -1;
+
+	/** 같은 로비에 몇 번째 다시 시도했는지. 첫 시도는 0 */
+	UPROPERTY(BlueprintReadOnly)
+	int32 RetryIndex = 0;
+
+	UPROPERTY(BlueprintReadOnly)
+	bool bSucceeded = false;
+
+	/** 실패했다면 다시 시도할 만한 오류였는지 */
+	UPROPERTY(BlueprintReadOnly)
+	bool bTransientError = false;
+
+	UPROPERTY(BlueprintReadOnly)
+	FString Error;
+
+	/** 참가 요청부터 응답까지 걸린 시간(초) */
+	UPROPERTY(BlueprintReadOnly)
+	float DurationSeconds = 0.f;
+};
+
+UENUM(BlueprintType)
+enum class EBlueprintLoginMethod : uint8
+{
+	None,
+	/** 이미 로그인된 로컬 유저를 찾았습니다 */
+	AlreadyLoggedIn,
+	/** 저장된 자격 증명으로 조용히 로그인했습니다 */
+	PersistentAuth,
+	/** 계정 포털을 띄워 로그인했습니다 */
+	AccountPortal
+};
+
+/** 로그인 단계별로 걸린 시간입니다. 시도하지 않은 단계는 -1입니다 */
+USTRUCT(BlueprintType)
+struct FLoginTimings
+{
+	GENERATED_BODY()
+
+	UPROPERTY(BlueprintReadOnly)
+	EBlueprintLoginMethod Method = EBlueprintLoginMethod::None;
+
+	UPROPERTY(BlueprintReadOnly)
+	float PersistentAuthSeconds = -1.f;
+
+	UPROPERTY(BlueprintReadOnly)
+	float AccountPortalSeconds = -1.f;
+
+	UPROPERTY(BlueprintReadOnly)
+	float TotalSeconds = 0.f;
+};
+
+/** 호스트가 게임을 시작할 때 단계별로 걸린 시간입니다. 두 단계는 동시에 진행됩니다 */
+USTRUCT(BlueprintType)
+struct FHostStartTimings
+{
+	GENERATED_BODY()
+
+	/** StartGameFromLobby부터 레벨 로드가 끝날 때까지(초) */
+	UPROPERTY(BlueprintReadOnly)
+	float MapLoadSeconds = 0.f;
+
+	/** StartGameFromLobby부터 MATCHSTATE=Starting 쓰기가 끝날 때까지(초) */
+	UPROPERTY(BlueprintReadOnly)
+	float AnnounceSeconds = 0.f;
+
+	/** StartGameFromLobby부터 ServerTravel 호출까지(초) */
+	UPROPERTY(BlueprintReadOnly)
+	float TotalSeconds = 0.f;
+
+	/** 로비를 만들 때 시작한 미리 읽기가 이미 끝나 있었는지 */
+	UPROPERTY(BlueprintReadOnly)
+	bool bMapWasPreloaded = false;
+
+	UPROPERTY(BlueprintReadOnly)
+	bool bAnnounceSucceeded = false;
+
+	/** 클라이언트 연결을 유지한 채 심리스 트래블로 이동했는지 */
+	UPROPERTY(BlueprintReadOnly)
+	bool bSeamlessTravel = false;
+};
+
+/** 로비 멤버 한 명이 들어오거나 나간 변화분입니다 */
+USTRUCT(BlueprintType)
+struct FBlueprintLobbyMemberDelta
+{
+	GENERATED_BODY()
+
+	UPROPERTY(BlueprintReadOnly)
+	int32 LobbyId = -1;
+
+	UPROPERTY(BlueprintReadOnly)
+	int32 MemberId = -1;
+
+	UPROPERTY(BlueprintReadOnly)
+	bool bIsLocalMember = false;
+};
+
+/** 로비(또는 로비 멤버) 속성의 변화분입니다. MemberId가 -1이면 로비 속성입니다 */
+USTRUCT(BlueprintType)
+struct FBlueprintLobbyAttributeDelta
+{
+	GENERATED_BODY()
+
+	UPROPERTY(BlueprintReadOnly)
+	int32 LobbyId = -1;
+
+	UPROPERTY(BlueprintReadOnly)
+	int32 MemberId = -1;
+
+	/** 추가되거나 바뀐 속성과 새 값 */
+	UPROPERTY(BlueprintReadOnly)
+	TMap<FName, FString> ChangedAttributes;
+
+	UPROPERTY(BlueprintReadOnly)
+	TArray<FName> RemovedAttributes;
 };
 
 USTRUCT(BlueprintType)
@@ -107,10 +314,10 @@ struct FBlueprintUserInfo
 	GENERATED_BODY()
 
 	FBlueprintUserInfo(){};
-	FBlueprintUserInfo(UE::Online::FUserInfo* InUserInfo) : User(InUserInfo), UserId(InUserInfo->AccountId.GetHandle())
-	, DisplayName(InUserInfo->DisplayName){};
+	explicit FBlueprintUserInfo(const UE::Online::FUserInfo& InUserInfo) : AccountId(InUserInfo.AccountId), UserId(InUserInfo.AccountId.GetHandle())
+	, DisplayName(InUserInfo.DisplayName){};
 	
-	const UE::Online::FUserInfo* User;
+	UE::Online::FAccountId AccountId;
 
 	UPROPERTY(BlueprintReadOnly)
 	int32 UserId = -1;
@@ -121,14 +328,59 @@ struct FBlueprintUserInfo
 
 };
 
+/** UE::Online::EUserPresenceStatus의 블루프린트용 사본 */
+UENUM(BlueprintType)
+enum class EBlueprintPresenceStatus : uint8
+{
+	Offline,
+	Online,
+	Away,
+	ExtendedAway,
+	DoNotDisturb,
+	Unknown
+};
+
+/** UE::Online::EUserPresenceJoinability의 블루프린트용 사본 */
+UENUM(BlueprintType)
+enum class EBlueprintPresenceJoinability : uint8
+{
+	Public,
+	FriendsOnly,
+	InviteOnly,
+	Private,
+	Unknown
+};
+
+/** 친구 한 명의 최신 현재 상태. 원본 FUserPresence를 가리키지 않고 값만 복사해 둡니다 */
 USTRUCT(BlueprintType)
 struct FBlueprintPresenceInfo
 {
 	GENERATED_BODY()
 
 	FBlueprintPresenceInfo(){};
+	explicit FBlueprintPresenceInfo(const UE::Online::FUserPresence& InPresence);
 
-	const UE::Online::FUserPresence* Presence = nullptr;
+	/** 내용이 바뀌었는지 비교합니다. AccountHandle은 보지 않습니다 */
+	bool HasSameState(const FBlueprintPresenceInfo& Other) const
+	{
+		return Status == Other.Status && Joinability == Other.Joinability
+			&& StatusString == Other.StatusString && RichPresenceString == Other.RichPresenceString;
+	}
+
+	UPROPERTY(BlueprintReadOnly)
+	int32 AccountHandle = -1;
+
+	UPROPERTY(BlueprintReadOnly)
+	EBlueprintPresenceStatus Status = EBlueprintPresenceStatus::Unknown;
+
+	UPROPERTY(BlueprintReadOnly)
+	EBlueprintPresenceJoinability Joinability = EBlueprintPresenceJoinability::Unknown;
+
+	UPROPERTY(BlueprintReadOnly)
+	FString StatusString;
+
+	UPROPERTY(BlueprintReadOnly)
+	FString RichPresenceString;
 };
 
 USTRUCT(BlueprintType)
@@ -137,10 +389,11 @@ struct FBlueprintFriendInfo
 	GENERATED_BODY()
 
 	FBlueprintFriendInfo(){};
-	FBlueprintFriendInfo(UE::Online::FFriend* InFriend) : Friend(InFriend), FriendId(InFriend->FriendId.GetHandle())
-	, DisplayName(InFriend->DisplayName), Nickname(InFriend->Nickname){};
+	/** 친구 목록 저장소의 슬롯 하나를 블루프린트용 값으로 꺼냅니다 */
+	FBlueprintFriendInfo(const FOnlineSampleFriendRoster& Roster, int32 Slot) : FriendAccountId(Roster.GetAccountId(Slot)), FriendId(Roster.GetHandle(Slot))
+	, DisplayName(Roster.GetDisplayName(Slot)), Nickname(Roster.GetNickname(Slot)){};
 	
-	const UE::Online::FFriend* Friend = nullptr;;
+	UE::Online::FAccountId FriendAccountId;
 
 	UPROPERTY(BlueprintReadOnly)
 	int32 FriendId = -1;
@@ -155,21 +408,99 @@ struct FBlueprintFriendInfo
 
 };
 
+/** 친구 목록을 다시 받았을 때 바뀐 부분입니다. 값은 FBlueprintFriendInfo::FriendId입니다 */
+USTRUCT(BlueprintType)
+struct FBlueprintFriendRosterDelta
+{
+	GENERATED_BODY()
+
+	UPROPERTY(BlueprintReadOnly)
+	TArray<int32> AddedFriendIds;
+
+	UPROPERTY(BlueprintReadOnly)
+	TArray<int32> RemovedFriendIds;
+
+	/** 표시 이름이나 별명이 바뀐 친구 */
+	UPROPERTY(BlueprintReadOnly)
+	TArray<int32> ChangedFriendIds;
+
+	bool IsEmpty() const { return AddedFriendIds.IsEmpty() && RemovedFriendIds.IsEmpty() && ChangedFriendIds.IsEmpty(); }
+};
+
 DECLARE_MULTICAST_DELEGATE_OneParam(FLoginComplete, bool bSucceeded);
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FLoginComplete_Dynamic, bool, bSucceeded);
 
+DECLARE_MULTICAST_DELEGATE_TwoParams(FLoginTimingsReported, bool bSucceeded, const FLoginTimings& Timings);
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_TwoParams(FLoginTimingsReported_Dynamic, bool, bSucceeded, const FLoginTimings&, Timings);
+
+DECLARE_MULTICAST_DELEGATE_ThreeParams(FAllLocalPlayersLoginComplete, bool bAllSucceeded, int32 NumSucceeded, int32 NumFailed);
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_ThreeParams(FAllLocalPlayersLoginComplete_Dynamic, bool, bAllSucceeded, int32, NumSucceeded, int32, NumFailed);
+
+DECLARE_MULTICAST_DELEGATE_TwoParams(FFindSessionsComplete, bool bSucceeded, int32 NumSessions);
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_TwoParams(FFindSessionsComplete_Dynamic, bool, bSucceeded, int32, NumSessions);
+
+DECLARE_MULTICAST_DELEGATE_ThreeParams(FCreateLobbyAndSessionComplete, bool bSucceeded, const FBlueprintLobbyInfo& LobbyInfo, const FBlueprintSessionInfo& SessionInfo);
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_ThreeParams(FCreateLobbyAndSessionComplete_Dynamic, bool, bSucceeded, const FBlueprintLobbyInfo&, LobbyInfo, const FBlueprintSessionInfo&, SessionInfo);
+
 DECLARE_MULTICAST_DELEGATE_OneParam(FCreateLobbyComplete, bool bSucceeded);
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FCreateLobbyComplete_Dynamic, bool, bSucceeded);
 
-DECLARE_MULTICAST_DELEGATE_OneParam(FLobbyInfoUpdated, FBlueprintLobbyInfo LobbyInfo);
-DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FLobbyInfoUpdated_Dynamic, FBlueprintLobbyInfo, LobbyInfo);
+DECLARE_MULTICAST_DELEGATE_OneParam(FLobbyInfoUpdated, const FBlueprintLobbyInfo& LobbyInfo);
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FLobbyInfoUpdated_Dynamic, const FBlueprintLobbyInfo&, LobbyInfo);
+
+DECLARE_MULTICAST_DELEGATE_OneParam(FLobbyMemberDelta, const FBlueprintLobbyMemberDelta& MemberDelta);
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FLobbyMemberDelta_Dynamic, const FBlueprintLobbyMemberDelta&, MemberDelta);
+
+DECLARE_MULTICAST_DELEGATE_OneParam(FLobbyAttributeDelta, const FBlueprintLobbyAttributeDelta& AttributeDelta);
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FLobbyAttributeDelta_Dynamic, const FBlueprintLobbyAttributeDelta&, AttributeDelta);
 
 DECLARE_MULTICAST_DELEGATE_OneParam(FFindLobbiesComplete, bool bSucceeded);
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FFindLobbiesComplete_Dynamic, bool, bSucceeded);
 
+DECLARE_MULTICAST_DELEGATE(FFoundLobbiesRefreshed);
+DECLARE_DYNAMIC_MULTICAST_DELEGATE(FFoundLobbiesRefreshed_Dynamic);
+
+DECLARE_MULTICAST_DELEGATE_FourParams(FFindLobbiesPageReceived, int32 PageIndex, int32 FirstNewIndex, int32 NumNewLobbies, bool bIsLastPage);
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_FourParams(FFindLobbiesPageReceived_Dynamic, int32, PageIndex, int32, FirstNewIndex, int32, NumNewLobbies, bool, bIsLastPage);
+
+DECLARE_MULTICAST_DELEGATE_OneParam(FFoundLobbiesRanked, bool bMeasured);
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FFoundLobbiesRanked_Dynamic, bool, bMeasured);
+
+DECLARE_MULTICAST_DELEGATE_TwoParams(FQosProbeComplete, const FString& HostAddress, float PingMs);
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_TwoParams(FQosProbeComplete_Dynamic, const FString&, HostAddress, float, PingMs);
+
 DECLARE_MULTICAST_DELEGATE_TwoParams(FJoinLobbyComplete, bool bSucceeded, FBlueprintLobbyInfo LobbyInfo);
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_TwoParams(FJoinLobbyComplete_Dynamic, bool, bSucceeded, FBlueprintLobbyInfo, LobbyInfo);
 
+DECLARE_MULTICAST_DELEGATE_ThreeParams(FJoinLobbyWithFailoverComplete, bool bSucceeded, const FBlueprintLobbyInfo& LobbyInfo, const TArray<FBlueprintLobbyJoinAttempt>& Attempts);
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_ThreeParams(FJoinLobbyWithFailoverComplete_Dynamic, bool, bSucceeded, const FBlueprintLobbyInfo&, LobbyInfo, const TArray<FBlueprintLobbyJoinAttempt>&, Attempts);
+
+DECLARE_MULTICAST_DELEGATE_ThreeParams(FJoinFriendLobbyComplete, bool bSucceeded, const FBlueprintLobbyInfo& LobbyInfo, bool bUsedSearch);
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_ThreeParams(FJoinFriendLobbyComplete_Dynamic, bool, bSucceeded, const FBlueprintLobbyInfo&, LobbyInfo, bool, bUsedSearch);
+
+DECLARE_MULTICAST_DELEGATE_TwoParams(FHostStartComplete, bool bSucceeded, const FHostStartTimings& Timings);
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_TwoParams(FHostStartComplete_Dynamic, bool, bSucceeded, const FHostStartTimings&, Timings);
+
+DECLARE_MULTICAST_DELEGATE_TwoParams(FQuickMatchComplete, EQuickMatchResult Result, const FBlueprintLobbyInfo& LobbyInfo);
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_TwoParams(FQuickMatchComplete_Dynamic, EQuickMatchResult, Result, const FBlueprintLobbyInfo&, LobbyInfo);
+
+DECLARE_MULTICAST_DELEGATE_ThreeParams(FFriendsPresenceQueryComplete, bool bSucceeded, int32 NumQueried, int32 NumFailed);
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_ThreeParams(FFriendsPresenceQueryComplete_Dynamic, bool, bSucceeded, int32, NumQueried, int32, NumFailed);
+
+DECLARE_MULTICAST_DELEGATE_OneParam(FFriendRosterChanged, const FBlueprintFriendRosterDelta& RosterDelta);
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FFriendRosterChanged_Dynamic, const FBlueprintFriendRosterDelta&, RosterDelta);
+
+DECLARE_MULTICAST_DELEGATE_OneParam(FFriendLastPlayedUpdated, int32 FriendId);
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FFriendLastPlayedUpdated_Dynamic, int32, FriendId);
+
+DECLARE_MULTICAST_DELEGATE_OneParam(FFriendPresenceUpdated, const FBlueprintPresenceInfo& PresenceInfo);
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FFriendPresenceUpdated_Dynamic, const FBlueprintPresenceInfo&, PresenceInfo);
+/** 위젯 하나가 친구 한 명만 구독할 때 쓰는 단일 델리게이트 */
+DECLARE_DYNAMIC_DELEGATE_OneParam(FFriendPresenceHandler_Dynamic, const FBlueprintPresenceInfo&, PresenceInfo);
+
+DECLARE_MULTICAST_DELEGATE_TwoParams(FUserInfoResolved, bool bSucceeded, const FBlueprintUserInfo& UserInfo);
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_TwoParams(FUserInfoResolved_Dynamic, bool, bSucceeded, const FBlueprintUserInfo&, UserInfo);
+
 DECLARE_MULTICAST_DELEGATE_OneParam(FGetFriendsComplete, bool bSucceeded);
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FGetFriendsComplete_Dynamic, bool, bSucceeded);
 
@@ -177,7 +508,7 @@ DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FGetFriendsComplete_Dynamic, bool, b
 /**
  * 
  */
-UCLASS()
+UCLASS(Config=Game)
 class ONLINETESTSAMPLE_API UOnlineSampleOnlineSubsystem : public UGameInstanceSubsystem
 {
 	GENERATED_BODY()
@@ -213,23 +544,119 @@ public:
 	void K2_CreateLobby(ULocalPlayer* LocalPlayer, const FCreateLobbyRequest & Request);
 	void CreateLobby(ULocalPlayer* LocalPlayer, const FCreateLobbyRequest & Request);
 
+	/**
+	 * 로비와 게임 세션을 동시에 만들고 같은 LINKID 속성으로 묶습니다.
+	 *		둘 다 만들어져야 성공이고, 한쪽만 성공했으면 그쪽을 정리한 뒤 실패로 끝냅니다. 완료 이벤트는 한 번만 옵니다
+	 */
+	UFUNCTION(BlueprintCallable)
+	void CreateLobbyAndSession(ULocalPlayer* LocalPlayer, const FCreateLobbyRequest& Request, bool bIsLanSession);
+
 	UFUNCTION(BlueprintCallable, DisplayName="Find Lobbies")
 	void K2_FindLobbies(ULocalPlayer* LocalPlayer);
 
+	/** 조건에 맞는 로비만 백엔드에서 받아옵니다. 스키마 검사에 실패하면 검색하지 않고 실패를 알립니다 */
+	UFUNCTION(BlueprintCallable, DisplayName="Find Lobbies With Query")
+	void K2_FindLobbiesWithQuery(ULocalPlayer* LocalPlayer, const FBlueprintLobbySearchQuery& Query);
+
 	//UFUNCTION(BlueprintCallable)
 	//void FindLobbiesByUser(ULocalPlayer* LocalPlayer, const FBlueprintUserInfo& UserInfo);
 
 	UFUNCTION(BlueprintCallable)
 	void FindLobbiesByUser(ULocalPlayer* LocalPlayer, const FBlueprintFriendInfo& FriendInfo);
 	void FindLobbies(ULocalPlayer* LocalPlayer, UE::Online::FFindLobbies::Params FindLobbyParams);
+
+	/**
+	 * 로비를 한 번 검색해 두고 결과를 PageSize씩 FoundLobbies 뒤에 이어 붙입니다.
+	 *		FFindLobbies에는 오프셋이 없어 백엔드 페이지 넘김이 아닙니다. 백엔드에는 MaxPagedLobbySearchResults개까지 한 번만 묻고,
+	 *		그보다 많은 로비는 페이지를 넘겨도 볼 수 없습니다
+	 */
+	UFUNCTION(BlueprintCallable, DisplayName="Find Lobbies Paged")
+	void K2_FindLobbiesPaged(ULocalPlayer* LocalPlayer, int32 PageSize, bool bAutoStream, const FBlueprintLobbySearchQuery& Query);
+	void FindLobbiesPaged(ULocalPlayer* LocalPlayer, UE::Online::FFindLobbies::Params FindLobbyParams, int32 PageSize, bool bAutoStream);
+
+	/** 받아둔 검색 결과에서 다음 페이지를 붙입니다. 검색 결과가 아직 오지 않았거나 남은 페이지가 없으면 false */
+	UFUNCTION(BlueprintCallable)
+	bool FetchNextLobbyPage();
+
+	/** 진행 중인 페이지 검색을 중단합니다. 이미 받은 결과는 유지됩니다 */
+	UFUNCTION(BlueprintCallable)
+	void CancelPagedLobbySearch();
+
+	UFUNCTION(BlueprintPure)
+	bool HasMoreLobbyPages() const;
+
+	/**
+	 * FoundLobbies의 호스트마다 QoS 에코를 동시에 보내고 RTT와 인원 비율로 다시 정렬합니다.
+	 *		bEnableLobbyQos가 켜져 있으면 검색이 끝날 때마다 자동으로 불립니다
+	 */
+	UFUNCTION(BlueprintCallable)
+	void RankFoundLobbiesByQos();
+
+	/** QoS 에코 응답자를 켭니다. 로비를 만들 때 자동으로 켜지고, 루프백 테스트용으로 직접 켤 수도 있습니다 */
+	UFUNCTION(BlueprintCallable)
+	bool StartQosResponder();
+	UFUNCTION(BlueprintCallable)
+	void StopQosResponder();
+
+	/** "IP:Port" 한 곳의 RTT를 잽니다. 결과는 OnQosProbeCompleteEvent로 옵니다 */
+	UFUNCTION(BlueprintCallable)
+	void ProbeQosAddress(const FString& HostAddress);
+
+	/**
+	 * 로비의 MAPNAME이 가리키는 레벨을 미리 비동기로 읽기 시작합니다.
+	 *		참가할 때 자동으로 불리고, 로비 목록에서 항목에 커서를 올렸을 때 불러도 됩니다. 한 번에 한 레벨만 들고 있습니다
+	 */
+	UFUNCTION(BlueprintCallable)
+	bool PreloadLobbyMap(const FBlueprintLobbyInfo& LobbyInfo);
+	UFUNCTION(BlueprintCallable)
+	void CancelLobbyMapPreload();
+
+	/** 로비 검색 캐시를 비웁니다. 다음 검색은 항상 백엔드로 갑니다 */
+	UFUNCTION(BlueprintCallable)
+	void InvalidateLobbySearchCache();
 	
 	
 	UFUNCTION(BlueprintCallable, DisplayName="Join Lobby")
 	void K2_JoinLobby(ULocalPlayer* LocalPlayer, const FBlueprintLobbyInfo& LobbyInfoToJoin);
+	/**
+	 * 친구가 있는 로비에 바로 참가합니다.
+	 *		현재 상태 저장소로 참가할 수 없는 친구는 요청 없이 거르고, 이미 받아둔 검색 결과에 친구가 든 로비가 있으면 검색 없이 참가합니다.
+	 *		그런 로비가 없거나 그 로비 참가가 실패했을 때만 친구를 대상으로 한 번 검색합니다
+	 */
 	UFUNCTION(BlueprintCallable)
 	void JoinFriendLobby(ULocalPlayer* LocalPlayer, const FBlueprintFriendInfo& FriendInfo);
 	void JoinLobby(ULocalPlayer* LocalPlayer, const FBlueprintLobbyInfo& LobbyInfoToJoin);
 
+	/**
+	 * 로비에 참가하고, 실패하면 알아서 복구합니다.
+	 *		시간 초과 같은 일시적인 오류는 지터를 섞은 백오프로 같은 로비에 다시 시도하고,
+	 *		꽉 찼거나 시작된 로비처럼 다시 해도 안 될 오류는 마지막 FoundLobbies의 다음 후보로 넘어갑니다
+	 */
+	UFUNCTION(BlueprintCallable)
+	void JoinLobbyWithFailover(ULocalPlayer* LocalPlayer, const FBlueprintLobbyInfo& LobbyInfoToJoin);
+	UFUNCTION(BlueprintCallable)
+	void CancelJoinLobbyWithFailover();
+
+	/** 여러 조건의 로비 검색을 동시에 보내 가장 먼저 찾은 로비에 참가하고, 시간 안에 못 찾으면 로비를 만듭니다 */
+	UFUNCTION(BlueprintCallable)
+	void QuickMatch(ULocalPlayer* LocalPlayer, const FQuickMatchRequest& Request);
+	/**
+	 * 진행 중인 빠른 매칭을 멈춥니다. 이미 보낸 검색 결과는 무시하고, 이미 보낸 참가가 성공하면 바로 나갑니다.
+	 *		이미 보낸 로비 생성은 되돌리지 않습니다
+	 */
+	UFUNCTION(BlueprintCallable)
+	void CancelQuickMatch();
+	UFUNCTION(BlueprintPure)
+	bool IsQuickMatchInProgress() const;
+
+	/** 참가 중인 모든 로비의 현재 정보를 돌려줍니다 */
+	UFUNCTION(BlueprintCallable)
+	TArray<FBlueprintLobbyInfo> GetJoinedLobbies() const;
+
+	/** 특정 로비의 갱신만 구독합니다. 참가 중이 아닌 로비면 무효 핸들을 돌려줍니다 */
+	FDelegateHandle AddLobbyUpdatedHandler(const UE::Online::FLobbyId& LobbyId, FLobbyInfoUpdated::FDelegate&& Delegate);
+	bool RemoveLobbyUpdatedHandler(const UE::Online::FLobbyId& LobbyId, FDelegateHandle Handle);
+
 	UFUNCTION(BlueprintCallable, DisplayName="Leave Lobby")
 	void K2_LeaveLobby(ULocalPlayer* LocalPlayer, FBlueprintLobbyInfo LobbyInfo);
 	void LeaveLobby(ULocalPlayer* LocalPlayer, UE::Online::FLobbyId LobbyId);
@@ -238,9 +665,70 @@ public:
 	UFUNCTION(BlueprintCallable)
 	void InitFriendsInfo(ULocalPlayer* LocalPlayer);
 
+	/**
+	 * 친구 목록 전체의 현재 상태를 BatchQueryPresence로 나눠 묻습니다.
+	 *		PresenceBatchSize명씩 묶고 동시에 MaxPresenceBatchesInFlight개까지만 보내며, 다 끝나면 이벤트를 한 번만 보냅니다
+	 */
+	UFUNCTION(BlueprintCallable)
+	void QueryFriendsPresence(ULocalPlayer* LocalPlayer);
+
+	/** 친구 목록을 저장소 슬롯 순서대로 꺼냅니다 */
+	UFUNCTION(BlueprintCallable)
+	void GetFriendInfos(TArray<FBlueprintFriendInfo>& OutFriendInfos) const;
+	UFUNCTION(BlueprintCallable)
+	bool GetFriendInfo(int32 FriendId, FBlueprintFriendInfo& OutFriendInfo) const;
+	UFUNCTION(BlueprintPure)
+	int32 GetNumFriends() const { return FriendRoster.Num(); }
+	/** 정렬/필터 뷰가 슬롯 번호로 직접 읽을 때 씁니다 */
+	const FOnlineSampleFriendRoster& GetFriendRoster() const { return FriendRoster; }
+
+	/** 친구가 마지막으로 같은 로비에 들어온 UTC 시각. 같이 있었던 적이 없으면 기본값(0 틱) */
+	UFUNCTION(BlueprintPure)
+	FDateTime GetFriendLastPlayedTime(int32 FriendId) const;
+
+	/** 저장된 친구의 최신 현재 상태를 꺼냅니다. 아직 받은 적이 없으면 false */
+	UFUNCTION(BlueprintCallable)
+	bool GetFriendPresence(int32 FriendId, FBlueprintPresenceInfo& OutPresenceInfo) const;
+
+	/** 친구 한 명의 현재 상태가 바뀔 때만 불립니다. 친구 목록에서 빠져도 구독은 유지됩니다 */
+	FDelegateHandle AddFriendPresenceHandler(int32 FriendId, FFriendPresenceUpdated::FDelegate&& Handler);
+	bool RemoveFriendPresenceHandler(int32 FriendId, FDelegateHandle Handle);
+
+	UFUNCTION(BlueprintCallable, DisplayName="Subscribe Friend Presence")
+	void K2_SubscribeFriendPresence(int32 FriendId, FFriendPresenceHandler_Dynamic Handler);
+	UFUNCTION(BlueprintCallable, DisplayName="Unsubscribe Friend Presence")
+	void K2_UnsubscribeFriendPresence(int32 FriendId, FFriendPresenceHandler_Dynamic Handler);
+
+	/** 로비 속성 쓰기를 큐에 넣습니다. 같은 프레임에 쌓인 쓰기는 다음 프레임에 한 번에 보냅니다 */
+	UFUNCTION(BlueprintCallable, DisplayName="Queue Lobby Attribute")
+	void K2_QueueLobbyAttribute(ULocalPlayer* LocalPlayer, const FBlueprintLobbyInfo& LobbyInfo, FName AttributeName, const FString& Value);
+	UFUNCTION(BlueprintCallable, DisplayName="Queue Lobby Member Attribute")
+	void K2_QueueLobbyMemberAttribute(ULocalPlayer* LocalPlayer, const FBlueprintLobbyInfo& LobbyInfo, FName AttributeName, const FString& Value);
+	
+	/** 같은 키를 여러 번 쓰면 마지막 값만 보냅니다 */
+	void QueueLobbyAttribute(ULocalPlayer* LocalPlayer, const UE::Online::FLobbyId& LobbyId, UE::Online::FSchemaAttributeId AttributeName, UE::Online::FSchemaVariant Value);
+	void QueueLobbyAttributeRemoval(ULocalPlayer* LocalPlayer, const UE::Online::FLobbyId& LobbyId, UE::Online::FSchemaAttributeId AttributeName);
+	void QueueLobbyMemberAttribute(ULocalPlayer* LocalPlayer, const UE::Online::FLobbyId& LobbyId, UE::Online::FSchemaAttributeId AttributeName, UE::Online::FSchemaVariant Value);
+	void QueueLobbyMemberAttributeRemoval(ULocalPlayer* LocalPlayer, const UE::Online::FLobbyId& LobbyId, UE::Online::FSchemaAttributeId AttributeName);
+
+	/**
+	 * 큐에 쌓인 로비/멤버 속성 쓰기를 지금 보냅니다.
+	 *		로비 속성과 멤버 속성 요청은 동시에 나가고, 모든 요청이 끝나면 OnComplete가 한 번 불립니다
+	 */
+	void FlushLobbyAttributeWrites(TFunction<void(bool bSucceeded)>&& OnComplete = TFunction<void(bool)>());
+
+	/**
+	 * 호스트가 게임을 시작합니다.
+	 *		레벨 로드와 MATCHSTATE=Starting 알림을 동시에 진행하고, 둘 다 끝나면 ServerTravel합니다
+	 */
 	UFUNCTION(BlueprintCallable)
 	void StartGameFromLobby(ULocalPlayer* LocalPlayer, FBlueprintLobbyInfo LobbyInfo);
 	void TravelToLobby(ULocalPlayer* LocalPlayer, FBlueprintLobbyInfo LobbyInfo);
+	/**
+	 * 심리스 트래블로 최종 레벨에 도착했을 때 플레이어 컨트롤러가 부릅니다.
+	 *		서브시스템의 로비 상태는 그대로 남아 있으니, 새 레벨의 UI가 다시 받을 수 있게 알림만 다시 보냅니다
+	 */
+	void HandleSeamlessTravelComplete(ULocalPlayer* LocalPlayer);
 	
 	// UFUNCTION(BlueprintCallable, DisplayName="Get Friends")
 	// void K2_GetFriends(ULocalPlayer* LocalPlayer);
@@ -252,30 +740,90 @@ public:
 	
 	// UFUNCTION(BlueprintCallable, DisplayName="Get User Info")
 	// void K2_GetUserInfo(ULocalPlayer* LocalPlayer, );
+	/** 여러 계정의 유저 정보를 캐시를 거쳐 받습니다. 받은 정보는 FoundUsers에 모이고 계정마다 OnUserInfoResolved가 옵니다 */
 	void GetUserInfo(ULocalPlayer* LocalPlayer, TArray<UE::Online::FAccountId> TargetUsers);
+	/**
+	 * 계정 하나의 유저 정보를 받습니다.
+	 *		TTL 안에 받은 적이 있으면 바로 채워진 퓨처를 돌려주고, 아니면 이번 프레임의 다른 요청과 묶어 다음 프레임에 한 번에 묻습니다.
+	 *		이미 묻고 있는 계정이면 그 응답을 같이 기다립니다. 실패하면 UserId가 -1인 값이 옵니다
+	 */
+	TFuture<FBlueprintUserInfo> ResolveUserInfo(ULocalPlayer* LocalPlayer, const UE::Online::FAccountId& TargetUser);
+	/** 캐시를 비웁니다. 진행 중인 조회의 결과는 그대로 받습니다 */
+	UFUNCTION(BlueprintCallable)
+	void InvalidateUserInfoCache();
 
 	
 	
 	//로그인
+	/**
+	 * 로그인합니다. PersistentAuth로 조용히 먼저 시도하고,
+	 *		그게 실패했을 때만 계정 포털로 넘어갑니다. 단계별 시간은 OnLoginTimingsReported로 옵니다
+	 */
 	void Login(FPlatformUserId PlatformUserId);
+	/**
+	 * 스플릿스크린의 모든 로컬 플레이어를 동시에 로그인합니다.
+	 *		유저별 로그인은 서로 기다리지 않고, 모두 끝나면 OnAllLocalPlayersLoginComplete가 한 번 옵니다
+	 */
+	UFUNCTION(BlueprintCallable)
+	void LoginAllLocalPlayers();
 	void Logout();
 	bool IsLoggedIn(ULocalPlayer* LocalPlayer);
 
+	/** GameInstance의 로컬 플레이어 목록에서의 순서입니다. 없으면 INDEX_NONE */
+	int32 GetLocalUserIndex(FPlatformUserId PlatformUserId) const;
+	/** 계정으로 로그인한 로컬 플레이어를 찾습니다 */
+	ULocalPlayer* FindLocalPlayerByAccountId(UE::Online::FAccountId AccountId) const;
+	/** 로비 멤버인 로컬 플레이어를 찾습니다. 여러 명이면 로컬 플레이어 순서가 앞선 쪽이므로 요청한 계정을 알 때는 쓰지 않습니다 */
+	ULocalPlayer* FindLocalPlayerInLobby(const UE::Online::FLobby& Lobby) const;
+
 	//임시 함수들
 	
 	
 	// UFUNCTION(BlueprintCallable)
 	// TArray<FBlueprintSessionInfo> GetFoundSessions() {return FoundSessions;};
 		
+	/** 세션을 찾아 FoundSessions에 요약을 채웁니다. 요약은 프레임마다 나눠 만들고 다 끝나면 OnFindSessionsComplete가 한 번 옵니다 */
 	UFUNCTION(BlueprintCallable)
 	void K2_FindSessions(APlayerController* PlayerController, int32 MaxResults, bool bUseLan);
 
+	/**
+	 * LAN 비컨 브로드캐스트로 세션을 찾습니다. 로그인도 백엔드도 쓰지 않습니다.
+	 *		응답이 오는 대로 FoundSessions에 넣고 LanDiscoveryTimeoutSeconds 뒤에 OnFindSessionsComplete를 보냅니다
+	 */
+	UFUNCTION(BlueprintCallable)
+	void FindLanSessions(int32 MaxResults);
+	/**
+	 * LAN 비컨 응답자를 켭니다. LAN 세션을 만드는 데 성공하면 자동으로 켜지고, 루프백 테스트용으로 직접 켤 수도 있습니다.
+	 *		리슨 서버로 접속을 받고 있을 때만 질의에 답합니다
+	 */
+	UFUNCTION(BlueprintCallable)
+	bool StartLanBeacon(int32 MaxPlayers);
+	UFUNCTION(BlueprintCallable)
+	void StopLanBeacon();
+	/** LAN 비컨으로 찾은 세션의 호스트로 바로 접속합니다 */
+	UFUNCTION(BlueprintCallable, DisplayName="Join Lan Session")
+	void K2_JoinLanSession(APlayerController* PlayerController, const FBlueprintSessionInfo& SessionInfo);
+
 	/// Events
 	
 	FLoginComplete OnLoginCompleteEvent;
 	UPROPERTY(BlueprintAssignable, meta = (DisplayName = "On Login Complete"))
 	FLoginComplete_Dynamic K2_OnLoginCompleteEvent;
+
+	/** OnLoginComplete와 같은 때 옵니다 */
+	FLoginTimingsReported OnLoginTimingsReportedEvent;
+	UPROPERTY(BlueprintAssignable, meta = (DisplayName = "On Login Timings Reported"))
+	FLoginTimingsReported_Dynamic K2_OnLoginTimingsReportedEvent;
+
+	/** LoginAllLocalPlayers로 시작한 로그인이 모두 끝났을 때 옵니다 */
+	FAllLocalPlayersLoginComplete OnAllLocalPlayersLoginCompleteEvent;
+	UPROPERTY(BlueprintAssignable, meta = (DisplayName = "On All Local Players Login Complete"))
+	FAllLocalPlayersLoginComplete_Dynamic K2_OnAllLocalPlayersLoginCompleteEvent;
 	
+	FCreateLobbyAndSessionComplete OnCreateLobbyAndSessionCompleteEvent;
+	UPROPERTY(BlueprintAssignable, meta = (DisplayName = "On Create Lobby And Session Complete"))
+	FCreateLobbyAndSessionComplete_Dynamic K2_OnCreateLobbyAndSessionCompleteEvent;
+
 	FCreateLobbyComplete OnCreateLobbyCompleteEvent;
 	UPROPERTY(BlueprintAssignable, meta = (DisplayName = "On Create Lobby Complete"))
 	FCreateLobbyComplete_Dynamic K2_OnCreateLobbyCompleteEvent;
@@ -288,10 +836,90 @@ public:
 	UPROPERTY(BlueprintAssignable, meta = (DisplayName = "On Lobby Info Updated"))
 	FLobbyInfoUpdated_Dynamic K2_OnLobbyInfoUpdatedEvent;
 
+	/** JoinedLobby뿐 아니라 참가 중인 모든 로비의 갱신을 받습니다. LobbyId로 구분합니다 */
+	FLobbyInfoUpdated OnAnyLobbyInfoUpdatedEvent;
+	UPROPERTY(BlueprintAssignable, meta = (DisplayName = "On Any Lobby Info Updated"))
+	FLobbyInfoUpdated_Dynamic K2_OnAnyLobbyInfoUpdatedEvent;
+
+	/** 로비 변화분 이벤트. JoinedLobby 전체를 다시 그리지 않고 위젯 한 줄만 고칠 때 사용합니다 */
+	FLobbyMemberDelta OnLobbyMemberAddedEvent;
+	UPROPERTY(BlueprintAssignable, meta = (DisplayName = "On Lobby Member Added"))
+	FLobbyMemberDelta_Dynamic K2_OnLobbyMemberAddedEvent;
+
+	FLobbyMemberDelta OnLobbyMemberRemovedEvent;
+	UPROPERTY(BlueprintAssignable, meta = (DisplayName = "On Lobby Member Removed"))
+	FLobbyMemberDelta_Dynamic K2_OnLobbyMemberRemovedEvent;
+
+	FLobbyAttributeDelta OnLobbyAttributesChangedEvent;
+	UPROPERTY(BlueprintAssignable, meta = (DisplayName = "On Lobby Attributes Changed"))
+	FLobbyAttributeDelta_Dynamic K2_OnLobbyAttributesChangedEvent;
+
 	FFindLobbiesComplete OnFindLobbiesCompleteEvent;
 	UPROPERTY(BlueprintAssignable, meta = (DisplayName = "On Find Lobbies Complete"))
 	FFindLobbiesComplete_Dynamic K2_OnFindLobbiesCompleteEvent;
 
+	/** 오래된 캐시로 OnFindLobbiesComplete를 보낸 뒤 백그라운드 갱신이 성공해 FoundLobbies가 바뀌었을 때 옵니다. 갱신이 실패하면 오지 않습니다 */
+	FFoundLobbiesRefreshed OnFoundLobbiesRefreshedEvent;
+	UPROPERTY(BlueprintAssignable, meta = (DisplayName = "On Found Lobbies Refreshed"))
+	FFoundLobbiesRefreshed_Dynamic K2_OnFoundLobbiesRefreshedEvent;
+
+	FFoundLobbiesRanked OnFoundLobbiesRankedEvent;
+	UPROPERTY(BlueprintAssignable, meta = (DisplayName = "On Found Lobbies Ranked"))
+	FFoundLobbiesRanked_Dynamic K2_OnFoundLobbiesRankedEvent;
+
+	FQosProbeComplete OnQosProbeCompleteEvent;
+	UPROPERTY(BlueprintAssignable, meta = (DisplayName = "On Qos Probe Complete"))
+	FQosProbeComplete_Dynamic K2_OnQosProbeCompleteEvent;
+
+	FFindLobbiesPageReceived OnFindLobbiesPageReceivedEvent;
+	UPROPERTY(BlueprintAssignable, meta = (DisplayName = "On Find Lobbies Page Received"))
+	FFindLobbiesPageReceived_Dynamic K2_OnFindLobbiesPageReceivedEvent;
+
+	FJoinLobbyWithFailoverComplete OnJoinLobbyWithFailoverCompleteEvent;
+	UPROPERTY(BlueprintAssignable, meta = (DisplayName = "On Join Lobby With Failover Complete"))
+	FJoinLobbyWithFailoverComplete_Dynamic K2_OnJoinLobbyWithFailoverCompleteEvent;
+
+	FJoinFriendLobbyComplete OnJoinFriendLobbyCompleteEvent;
+	UPROPERTY(BlueprintAssignable, meta = (DisplayName = "On Join Friend Lobby Complete"))
+	FJoinFriendLobbyComplete_Dynamic K2_OnJoinFriendLobbyCompleteEvent;
+
+	FHostStartComplete OnHostStartCompleteEvent;
+	UPROPERTY(BlueprintAssignable, meta = (DisplayName = "On Host Start Complete"))
+	FHostStartComplete_Dynamic K2_OnHostStartCompleteEvent;
+
+	FQuickMatchComplete OnQuickMatchCompleteEvent;
+	UPROPERTY(BlueprintAssignable, meta = (DisplayName = "On Quick Match Complete"))
+	FQuickMatchComplete_Dynamic K2_OnQuickMatchCompleteEvent;
+
+	FFriendsPresenceQueryComplete OnFriendsPresenceQueryCompleteEvent;
+	UPROPERTY(BlueprintAssignable, meta = (DisplayName = "On Friends Presence Query Complete"))
+	FFriendsPresenceQueryComplete_Dynamic K2_OnFriendsPresenceQueryCompleteEvent;
+
+	/** 친구 목록을 다시 받아서 실제로 바뀐 것이 있을 때만 옵니다. OnGetFriendsComplete보다 먼저 옵니다 */
+	FFriendRosterChanged OnFriendRosterChangedEvent;
+	UPROPERTY(BlueprintAssignable, meta = (DisplayName = "On Friend Roster Changed"))
+	FFriendRosterChanged_Dynamic K2_OnFriendRosterChangedEvent;
+
+	/** 친구가 내가 있는 로비에 새로 들어왔을 때 옵니다. 최근 같이 한 순서 정렬에 씁니다 */
+	FFriendLastPlayedUpdated OnFriendLastPlayedUpdatedEvent;
+	UPROPERTY(BlueprintAssignable, meta = (DisplayName = "On Friend Last Played Updated"))
+	FFriendLastPlayedUpdated_Dynamic K2_OnFriendLastPlayedUpdatedEvent;
+
+	/** 저장된 친구 중 누구든 현재 상태가 바뀌면 옵니다 */
+	FFriendPresenceUpdated OnFriendPresenceUpdatedEvent;
+	UPROPERTY(BlueprintAssignable, meta = (DisplayName = "On Friend Presence Updated"))
+	FFriendPresenceUpdated_Dynamic K2_OnFriendPresenceUpdatedEvent;
+
+	/** 세션 검색이 끝나 FoundSessions 요약을 다 만들었을 때 한 번 옵니다. 로그인하지 않았거나 검색이 실패해도 옵니다 */
+	FFindSessionsComplete OnFindSessionsCompleteEvent;
+	UPROPERTY(BlueprintAssignable, meta = (DisplayName = "On Find Sessions Complete"))
+	FFindSessionsComplete_Dynamic K2_OnFindSessionsCompleteEvent;
+
+	/** 백엔드에서 새로 받은 계정마다 옵니다. 캐시에서 꺼낸 경우에는 오지 않습니다 */
+	FUserInfoResolved OnUserInfoResolvedEvent;
+	UPROPERTY(BlueprintAssignable, meta = (DisplayName = "On User Info Resolved"))
+	FUserInfoResolved_Dynamic K2_OnUserInfoResolvedEvent;
+
 	FGetFriendsComplete OnGetFriendsCompleteEvent;
 	UPROPERTY(BlueprintAssignable, meta = (DisplayName = "On Get Friends Complete"))
 	FGetFriendsComplete_Dynamic K2_OnGetFriendsCompleteEvent;
@@ -301,6 +929,125 @@ public:
 
 	UPROPERTY(BlueprintReadWrite)
 	TSoftObjectPtr<UWorld> MyMap;//
+
+	/** 일반 FindLobbies 한 번에 받을 최대 로비 수 */
+	UPROPERTY(Config, BlueprintReadWrite)
+	int32 MaxLobbySearchResults = 10;
+
+	/** 페이지 검색이 FoundLobbies에 붙일 최대 페이지 수. 이 수만큼 FoundLobbies 공간을 미리 잡아둡니다 */
+	UPROPERTY(Config, BlueprintReadWrite)
+	int32 MaxLobbySearchPages = 10;
+
+	/** 페이지 검색이 백엔드에 한 번 요청해 받는 최대 로비 수. 페이지 검색의 전체 결과도 여기서 끝납니다 */
+	UPROPERTY(Config, BlueprintReadWrite)
+	int32 MaxPagedLobbySearchResults = 50;
+
+	/** 같은 조건의 로비 검색 결과를 캐시에서 돌려줄지 여부 */
+	UPROPERTY(Config, BlueprintReadWrite)
+	bool bEnableLobbySearchCache = true;
+
+	/** 이 시간(초)이 지나면 캐시 결과를 돌려주면서 뒤에서 다시 검색합니다 */
+	UPROPERTY(Config, BlueprintReadWrite)
+	float LobbySearchCacheTTLSeconds = 5.f;
+
+	/** 이 시간(초)보다 오래된 캐시는 돌려주지 않고 검색 결과를 기다립니다 */
+	UPROPERTY(Config, BlueprintReadWrite)
+	float LobbySearchCacheMaxAgeSeconds = 60.f;
+
+	/** true면 로비 갱신 알림을 모아서 한 번만 보냅니다 */
+	UPROPERTY(Config, BlueprintReadWrite)
+	bool bCoalesceLobbyNotifications = true;
+
+	/** 알림을 모으는 간격(초). 0이면 다음 프레임에 한 번 보냅니다 */
+	UPROPERTY(Config, BlueprintReadWrite)
+	float LobbyNotifyCoalesceIntervalSeconds = 0.f;
+
+	/** 로비 검색 뒤 호스트 RTT를 재서 FoundLobbies를 다시 정렬할지 여부 */
+	UPROPERTY(Config, BlueprintReadWrite)
+	bool bEnableLobbyQos = true;
+
+	/** 호스트 QoS 응답자 포트. 0이면 빈 포트를 쓰고 QOSADDR 속성으로 알립니다 */
+	UPROPERTY(Config, BlueprintReadWrite)
+	int32 QosResponderPort = 0;
+
+	UPROPERTY(Config, BlueprintReadWrite)
+	int32 QosPingsPerHost = 3;
+
+	UPROPERTY(Config, BlueprintReadWrite)
+	float QosProbeTimeoutSeconds = 0.5f;
+
+	/** 인원 비율 1.0이 RTT 몇 ms만큼 유리한지. 비슷한 거리면 사람이 더 찬 로비를 앞에 둡니다 */
+	UPROPERTY(Config, BlueprintReadWrite)
+	float QosFillRatioWeightMs = 20.f;
+
+	/** 일시적인 오류에서 같은 로비에 다시 시도할 최대 횟수 */
+	UPROPERTY(Config, BlueprintReadWrite)
+	int32 JoinMaxRetriesPerLobby = 2;
+
+	/** 재시도 간격은 Base * 2^n을 Max로 자른 뒤 절반은 고정, 절반은 무작위로 둡니다 */
+	UPROPERTY(Config, BlueprintReadWrite)
+	float JoinRetryBaseDelaySeconds = 0.25f;
+
+	UPROPERTY(Config, BlueprintReadWrite)
+	float JoinRetryMaxDelaySeconds = 2.f;
+
+	/** 처음 고른 로비를 포함해 차례로 시도할 로비 수 */
+	UPROPERTY(Config, BlueprintReadWrite)
+	int32 JoinMaxCandidates = 5;
+
+	/**
+	 * 호스트가 이미 리슨 서버로 클라이언트를 받고 있을 때 게임 시작을 심리스 트래블로 할지 여부.
+	 *		전환 레벨은 GameMapsSettings의 TransitionMap을 쓰고, 비어 있으면 엔진이 만드는 빈 월드를 씁니다
+	 */
+	UPROPERTY(Config, BlueprintReadWrite)
+	bool bEnableSeamlessTravel = true;
+
+	/** LAN 비컨이 쓰는 UDP 포트. 호스트와 클라이언트가 같아야 합니다 */
+	UPROPERTY(Config, BlueprintReadWrite)
+	int32 LanBeaconPort = 14001;
+
+	/** LAN 비컨 응답을 기다리는 시간(초) */
+	UPROPERTY(Config, BlueprintReadWrite)
+	float LanDiscoveryTimeoutSeconds = 0.3f;
+
+	/** 브로드캐스트와 함께 루프백으로도 질의합니다. 같은 머신의 호스트를 브로드캐스트 없이 찾습니다 */
+	UPROPERTY(Config, BlueprintReadWrite)
+	bool bLanDiscoveryIncludeLoopback = true;
+
+	/** 계정 포털 전에 SDK가 보관한 리프레시 토큰으로 PersistentAuth를 먼저 시도합니다 */
+	UPROPERTY(Config, BlueprintReadWrite)
+	bool bEnablePersistentLogin = true;
+
+	/** 찾은 세션 요약을 한 프레임에 몇 개까지 만들지 */
+	UPROPERTY(Config, BlueprintReadWrite)
+	int32 SessionSummariesPerFrame = 16;
+
+	/** 받은 유저 정보를 다시 묻지 않고 쓸 시간(초) */
+	UPROPERTY(Config, BlueprintReadWrite)
+	float UserInfoCacheTTLSeconds = 300.f;
+
+	/** QueryUserInfo 한 번에 넣을 계정 수 */
+	UPROPERTY(Config, BlueprintReadWrite)
+	int32 UserInfoQueryBatchSize = 50;
+
+	/** BatchQueryPresence 한 번에 넣을 친구 수 */
+	UPROPERTY(Config, BlueprintReadWrite)
+	int32 PresenceBatchSize = 50;
+
+	/** 동시에 보낼 BatchQueryPresence 수 */
+	UPROPERTY(Config, BlueprintReadWrite)
+	int32 MaxPresenceBatchesInFlight = 4;
+
+	/** 로비에 참가할 때 ClientTravel보다 먼저 목적지 레벨을 읽기 시작할지 여부 */
+	UPROPERTY(Config, BlueprintReadWrite)
+	bool bEnableLobbyMapPreload = true;
+
+	/**
+	 * 레벨 경로 대신 MAPNAME에 싣는 별칭. 키는 MAPNAME 값입니다.
+	 *		로비를 만들 때 레벨에 별칭이 있으면 별칭을 싣습니다. 경로가 스키마의 MAPNAME MaxSize보다 긴 레벨은 별칭이 있어야 만들 수 있습니다
+	 */
+	UPROPERTY(Config, BlueprintReadWrite)
+	TMap<FString, FSoftObjectPath> LobbyMapAliases;
 	
 protected:
  
@@ -356,33 +1103,431 @@ protected:
 	
 	// 로그인 이벤트 처리...는 나중에 구현.
 	void HandleLogin(const UE::Online::TOnlineResult<UE::Online::FAuthLogin>& LoginResult);
+
+	struct FLoginPipelineState
+	{
+		FLoginTimings Timings;
+		double StartTime = 0.0;
+		double StageStartTime = 0.0;
+	};
+
+	/** 로그인 단계 하나를 보냅니다 */
+	void SendLoginStage(FPlatformUserId PlatformUserId, FName CredentialsType);
+	/** PersistentAuth가 실패하면 계정 포털로 넘어갑니다 */
+	void HandleLoginStage(const UE::Online::TOnlineResult<UE::Online::FAuthLogin>& LoginResult, FPlatformUserId PlatformUserId, FName CredentialsType);
+	void FinishLogin(FPlatformUserId PlatformUserId, bool bSucceeded, EBlueprintLoginMethod Method);
+
+	TMap<FPlatformUserId, FLoginPipelineState> LoginPipelines;
+
+	struct FMultiLoginState
+	{
+		bool bActive = false;
+		TSet<FPlatformUserId> PendingUsers;
+		int32 NumSucceeded = 0;
+		int32 NumFailed = 0;
+	};
+
+	/** 여러 유저 로그인 중 하나가 끝날 때마다 세고, 마지막이면 집계 이벤트를 보냅니다 */
+	void HandleMultiLoginResult(FPlatformUserId PlatformUserId, bool bSucceeded);
+
+	FMultiLoginState MultiLoginState;
 	void HandleCreateLobby(const UE::Online::TOnlineResult<UE::Online::FCreateLobby>& CreateLobbyResult);
+	/** 만든 로비를 로비 상태에 반영합니다. 이벤트는 보내지 않습니다 */
+	void ApplyCreatedLobby(const TSharedRef<const UE::Online::FLobby>& Lobby);
+	/** 로비 생성 파라미터를 채우고 이동할 레벨을 미리 읽기 시작합니다. MAPNAME을 만들 수 없으면 아무것도 하지 않고 false */
+	bool PrepareCreateLobbyParams(ULocalPlayer* LocalPlayer, const FCreateLobbyRequest& Request, UE::Online::FCreateLobby::Params& CreateLobbyParams);
 	// 세션 생성 비동기 이벤트 처리.
 	void HandleCreateSession(const UE::Online::TOnlineResult<UE::Online::FCreateSession>& CreateSessionResult );
 
 	void BindLobbyUpdatedEvents();
+	/** JoinedLobby 갱신을 알립니다 */
 	const void NotifyLobbyUpdated();
+	/** 특정 로비를 더티로 표시합니다. JoinedLobby라면 전체 이벤트도 함께 나갑니다 */
+	void MarkLobbyDirty(const UE::Online::FLobbyId& LobbyId);
+	void ScheduleLobbyNotificationFlush();
+	/** 모아둔 로비 갱신 알림을 지금 보냅니다 */
+	void FlushLobbyNotifications();
 	void HandleMemberJoinedLobby(const UE::Online::FLobbyMemberJoined& Info);
 	void HandleMemberLeftLobby(const UE::Online::FLobbyMemberLeft& Info);
 	void HandleJoinedLobby(const UE::Online::FLobbyJoined& Info);
 	void HandleLeftLobby(const UE::Online::FLobbyLeft& Info);
 	void HandleLobbyAttributeChanged(const UE::Online::FLobbyAttributesChanged& Info);
+	void HandleLobbyMemberAttributeChanged(const UE::Online::FLobbyMemberAttributesChanged& Info);
+
+	////////////////////////////////////////////////////////
+	/// 로비 상태 저장소
+
+	/** 참가 중인 로비 하나의 상태입니다 */
+	struct FLobbyStateEntry
+	{
+		FBlueprintLobbyInfo Info;
+		/** 이 로비만 구독하는 쪽 */
+		FLobbyInfoUpdated OnUpdated;
+		bool bDirty = false;
+	};
+
+	/**
+	 * 참가 중인 로비들을 FLobbyId로 들고 있는 저장소입니다.
+	 *		값은 연속 배열에 두고 인덱스 맵으로 O(1)에 찾습니다. 지울 때는 마지막 항목을 빈자리로 옮깁니다
+	 */
+	struct FLobbyStateStore
+	{
+		TArray<FLobbyStateEntry> Entries;
+		TMap<UE::Online::FLobbyId, int32> Indices;
+
+		FLobbyStateEntry* Find(const UE::Online::FLobbyId& LobbyId)
+		{
+			const int32* Index = Indices.Find(LobbyId);
+			return Index ? &Entries[*Index] : nullptr;
+		}
+
+		FLobbyStateEntry& Add(const TSharedRef<const UE::Online::FLobby>& Lobby)
+		{
+			const int32 Index = Entries.AddDefaulted();
+			Entries[Index].Info = FBlueprintLobbyInfo(Lobby);
+			Indices.Add(Lobby->LobbyId, Index);
+			return Entries[Index];
+		}
+
+		void Remove(const UE::Online::FLobbyId& LobbyId)
+		{
+			int32 Index = INDEX_NONE;
+			if(Indices.RemoveAndCopyValue(LobbyId, Index))
+			{
+				Entries.RemoveAtSwap(Index);
+				if(Entries.IsValidIndex(Index))
+				{
+					Indices.Add(Entries[Index].Info.Lobby->LobbyId, Index);
+				}
+			}
+		}
+	};
+
+	/**
+	 * 로비 이벤트의 최신 스냅샷을 저장소에 반영합니다.
+	 *		이미 있는 로비는 공유 포인터만 바꾸고, 처음 보는 로비만 멤버 목록까지 새로 만듭니다
+	 */
+	FLobbyStateEntry& UpdateLobbyState(const TSharedRef<const UE::Online::FLobby>& Lobby, bool& bOutIsNewEntry);
+	/** 저장소 항목을 JoinedLobby로 지정합니다 */
+	void SetPrimaryLobby(const FLobbyStateEntry& Entry);
+	bool IsPrimaryLobby(const UE::Online::FLobbyId& LobbyId) const;
+
+	FLobbyStateStore LobbyStates;
+	bool bPrimaryLobbyDirty = false;
 
 	void HandleFindLobbies(const UE::Online::TOnlineResult<UE::Online::FFindLobbies>& FindLobbiesResult);
-	void HandleJoinLobby(const UE::Online::TOnlineResult<UE::Online::FJoinLobby>& JoinLobbyResult);
+	/** 가장 최근 검색이 캐시로 이미 완료 이벤트를 받았으면 성공했을 때만 OnFoundLobbiesRefreshed를 보냅니다 */
+	void HandleCachedFindLobbies(const UE::Online::TOnlineResult<UE::Online::FFindLobbies>& FindLobbiesResult, const FString& CacheKey);
+	/** FoundLobbies를 검색 결과로 바꿉니다. 이미 잰 RTT는 같은 로비에 그대로 남깁니다 */
+	void SetFoundLobbies(const TArray<TSharedRef<const UE::Online::FLobby>>& Lobbies);
+	void HandleFindLobbiesPage(const UE::Online::TOnlineResult<UE::Online::FFindLobbies>& FindLobbiesResult, uint32 SearchSerial);
+	/** 커서에 받아둔 결과에서 다음 페이지를 FoundLobbies에 붙이고 페이지 이벤트를 보냅니다 */
+	void AppendNextLobbyPage();
+	/** 검색 조건을 검사하고 파라미터로 옮깁니다. 실패하면 로그를 남기고 false */
+	bool CompileLobbySearchQuery(const FBlueprintLobbySearchQuery& Query, UE::Online::FFindLobbies::Params& FindLobbyParams);
+	/** 검색 파라미터에 로컬 계정과 공통 필터를 채웁니다 */
+	void PrepareFindLobbiesParams(ULocalPlayer* LocalPlayer, UE::Online::FFindLobbies::Params& FindLobbyParams);
+	/** JoiningAccountId는 참가를 요청한 로컬 계정입니다. 그 플레이어로 이동하고 멤버 정보를 채웁니다 */
+	void HandleJoinLobby(const UE::Online::TOnlineResult<UE::Online::FJoinLobby>& JoinLobbyResult, UE::Online::FAccountId JoiningAccountId);
+
+	/** 응답을 기다리는 참가 요청. LobbyId -> 요청한 로컬 계정. OnLobbyJoined에는 로컬 계정이 없어서 여기서 찾습니다 */
+	TMap<UE::Online::FLobbyId, UE::Online::FAccountId> PendingLobbyJoins;
 
 	void HandleGetFriends(const UE::Online::TOnlineResult<UE::Online::FGetFriends>& GetFriendsResult);
-	void HandleGetUserInfo(const UE::Online::TOnlineResult<UE::Online::FGetUserInfo>& GetUserInfoResult);
+	/** 캐시 항목을 채우고 기다리던 퓨처를 모두 채웁니다 */
+	void HandleGetUserInfo(const UE::Online::TOnlineResult<UE::Online::FGetUserInfo>& GetUserInfoResult, const UE::Online::FAccountId& TargetUser);
 	
 	void BindPresenceUpdatedEvents();
 	void HandleFriendsUpdated(const UE::Online::FPresenceUpdated&);
 	const void NotifyPresenceUpdated();
 	
-	void AdjustLobbyAfterStart(ULocalPlayer* LocalPlayer, FBlueprintLobbyInfo LobbyInfo);
+	void AdjustLobbyAfterStart(ULocalPlayer* LocalPlayer, FBlueprintLobbyInfo LobbyInfo, TFunction<void(bool bSucceeded)>&& OnComplete = TFunction<void(bool)>());
 	
 	//데이터
 	TArray<UE::Online::FOnlineEventDelegateHandle> LobbyMemberChangeEvent_Handles;
 	TArray<UE::Online::FOnlineEventDelegateHandle> PresenceUpdatedEvent_Handles;
+
+	////////////////////////////////////////////////////////
+	/// 친구 현재 상태 일괄 조회
+
+	struct FPresenceBatchState
+	{
+		/** 조회를 시작할 때 한 번 꺼내둡니다. 도중에 로그아웃해도 남은 묶음은 이 계정으로 보냅니다 */
+		UE::Online::FAccountId LocalAccountId;
+		TArray<UE::Online::FAccountId> TargetAccountIds;
+		int32 NextIndex = 0;
+		int32 BatchesInFlight = 0;
+		int32 NumFailed = 0;
+		uint32 Serial = 0;
+		bool bActive = false;
+	};
+
+	/** 한도 안에서 다음 묶음들을 보냅니다. 보낼 것도 기다릴 것도 없으면 완료를 알립니다 */
+	void SendPresenceBatches();
+	void HandleBatchQueryPresence(const UE::Online::TOnlineResult<UE::Online::FBatchQueryPresence>& BatchQueryPresenceResult, uint32 Serial, int32 BatchSize);
+
+	FPresenceBatchState PresenceBatchState;
+
+	////////////////////////////////////////////////////////
+	/// 세션 검색
+
+	struct FSessionSearchState
+	{
+		TArray<UE::Online::FOnlineSessionId> PendingSessionIds;
+		int32 NextIndex = 0;
+		FTimerHandle TimerHandle;
+		uint32 Serial = 0;
+		bool bActive = false;
+	};
+
+	/** 남은 세션 ID를 SessionSummariesPerFrame개씩 요약으로 바꾸고, 남았으면 다음 프레임에 이어갑니다 */
+	void BuildFoundSessionSummaries();
+	void FinishFindSessions(bool bSucceeded);
+
+	FSessionSearchState SessionSearchState;
+
+	////////////////////////////////////////////////////////
+	/// 로비 + 세션 동시 생성
+
+	struct FHostSetupState
+	{
+		TWeakObjectPtr<ULocalPlayer> LocalPlayer;
+		/** 로컬 플레이어가 사라져도 되돌릴 수 있도록 요청한 계정을 따로 둡니다 */
+		UE::Online::FAccountId LocalAccountId;
+		FString LinkId;
+		FName SessionName;
+		TOptional<UE::Online::TOnlineResult<UE::Online::FCreateLobby>> LobbyResult;
+		TOptional<UE::Online::TOnlineResult<UE::Online::FCreateSession>> SessionResult;
+		uint32 Serial = 0;
+		bool bActive = false;
+		/** 둘 다 성공하면 이 값으로 LAN 비컨을 켭니다 */
+		bool bIsLanSession = false;
+		int32 MaxPlayers = 0;
+	};
+
+	/** 두 요청이 모두 돌아왔으면 결과를 맞추고, 한쪽만 성공했으면 그쪽을 되돌립니다 */
+	void TryFinishHostSetup();
+	void FinishHostSetup(bool bSucceeded, const FBlueprintLobbyInfo& LobbyInfo, const FBlueprintSessionInfo& SessionInfo);
+
+	FHostSetupState HostSetupState;
+
+	/** 비컨 질의가 올 때마다 현재 월드에서 호스트 정보를 만듭니다. 리슨 서버가 아니면 false입니다 */
+	bool MakeLanHostInfo(FOnlineSampleLanHostInfo& OutHostInfo) const;
+
+	TUniquePtr<FOnlineSampleLanBeaconHost> LanBeaconHost;
+	TUniquePtr<FOnlineSampleLanBeaconClient> LanBeaconClient;
+	int32 LanBeaconMaxPlayers = 0;
+
+	////////////////////////////////////////////////////////
+	/// 유저 정보 캐시
+
+	struct FUserInfoCacheEntry
+	{
+		FBlueprintUserInfo Info;
+		double FetchedTime = 0.0;
+		bool bQueryInFlight = false;
+		/** 조회가 끝나길 기다리는 호출자들 */
+		TArray<TPromise<FBlueprintUserInfo>> Waiters;
+	};
+
+	/** 이번 프레임에 모인 조회를 로컬 계정별로 묶어 보냅니다 */
+	void FlushUserInfoQueries();
+
+	TMap<UE::Online::FAccountId, FUserInfoCacheEntry> UserInfoCache;
+	/** 로컬 계정 -> 아직 보내지 않은 조회 대상 */
+	TMap<UE::Online::FAccountId, TArray<UE::Online::FAccountId>> PendingUserInfoQueries;
+	FTimerHandle UserInfoFlushTimerHandle;
+	////////////////////////////////////////////////////////
+	/// 친구 현재 상태 저장소
+
+	/**
+	 * 계정 핸들로 찾는 현재 상태 저장소입니다.
+	 *		값은 연속 배열에 두고 인덱스 맵으로 O(1)에 찾습니다. 구독자는 구독한 친구만 따로 들고 있습니다
+	 */
+	struct FPresenceStore
+	{
+		TArray<FBlueprintPresenceInfo> Entries;
+		TMap<int32, int32> Indices;
+
+		const FBlueprintPresenceInfo* Find(int32 AccountHandle) const
+		{
+			const int32* Index = Indices.Find(AccountHandle);
+			return Index ? &Entries[*Index] : nullptr;
+		}
+
+		void Remove(int32 AccountHandle)
+		{
+			int32 Index = INDEX_NONE;
+			if(Indices.RemoveAndCopyValue(AccountHandle, Index))
+			{
+				Entries.RemoveAtSwap(Index);
+				if(Entries.IsValidIndex(Index))
+				{
+					Indices.Add(Entries[Index].AccountHandle, Index);
+				}
+			}
+		}
+	};
+
+	/** 받은 현재 상태를 저장하고, 바뀌었을 때만 그 친구의 구독자와 전체 이벤트에 알립니다 */
+	void UpdateFriendPresence(const UE::Online::FUserPresence& Presence);
+
+	FPresenceStore FriendPresences;
+
+	/** 로비에 새로 보인 멤버 중 친구인 계정의 시각을 남깁니다. PreviousMembers가 없으면 모든 멤버가 새로 보인 것입니다 */
+	void RecordFriendsPlayedWith(const UE::Online::FLobby& Lobby, const TArray<int32>* PreviousMembers);
+	TMap<int32, FDateTime> FriendLastPlayedTimes;
+	TMap<int32, FFriendPresenceUpdated> FriendPresenceHandlers;
+	TMap<int32, TArray<FFriendPresenceHandler_Dynamic>> K2_FriendPresenceHandlers;
+	FDelegateHandle InitFriendsInfoHandle;
+
+	bool bLobbyNotifyPending = false;
+	FTimerHandle LobbyNotifyTimerHandle;
+
+	////////////////////////////////////////////////////////
+	/// 로비 속성 쓰기 큐
+
+	/** 한 로비, 한 로컬 계정에 대해 아직 보내지 않은 속성 쓰기입니다 */
+	struct FPendingLobbyAttributeWrite
+	{
+		TMap<UE::Online::FSchemaAttributeId, UE::Online::FSchemaVariant> LobbyAttributes;
+		TSet<UE::Online::FSchemaAttributeId> RemovedLobbyAttributes;
+		TMap<UE::Online::FSchemaAttributeId, UE::Online::FSchemaVariant> MemberAttributes;
+		TSet<UE::Online::FSchemaAttributeId> RemovedMemberAttributes;
+	};
+
+	/** (LobbyId, LocalAccountId) 쌍으로 쓰기를 합칩니다 */
+	FPendingLobbyAttributeWrite* FindOrAddPendingLobbyWrite(ULocalPlayer* LocalPlayer, const UE::Online::FLobbyId& LobbyId);
+	void HandleLobbyAttributeFlushTimer();
+	
+	TMap<TPair<UE::Online::FLobbyId, UE::Online::FAccountId>, FPendingLobbyAttributeWrite> PendingLobbyAttributeWrites;
+	FTimerHandle LobbyAttributeFlushTimerHandle;
+
+	////////////////////////////////////////////////////////
+	/// 로비 QoS
+
+	/** 로비의 QOSADDR 속성("IP:Port")을 읽습니다. 없으면 빈 문자열 */
+	static FString GetLobbyQosAddress(const UE::Online::FLobby& Lobby);
+	/** RTT와 인원 비율 점수로 FoundLobbies를 정렬합니다 */
+	void SortFoundLobbiesByQos();
+
+	TUniquePtr<FOnlineSampleQosResponder> QosResponder;
+	TUniquePtr<FOnlineSampleQosProber> LobbyQosProber;
+	TUniquePtr<FOnlineSampleQosProber> ManualQosProber;
+
+	////////////////////////////////////////////////////////
+	/// 빠른 매칭
+
+	/** 진행 중인 빠른 매칭. Serial이 바뀌면 늦게 도착한 검색/참가 결과는 버려집니다 */
+	struct FQuickMatchState
+	{
+		FQuickMatchRequest Request;
+		TWeakObjectPtr<ULocalPlayer> LocalPlayer;
+		/** 조건별로 돌아온 후보. 참가에 실패한 후보는 지워집니다 */
+		TArray<TArray<TSharedRef<const UE::Online::FLobby>>> TierCandidates;
+		TSet<UE::Online::FLobbyId> TriedLobbies;
+		FTimerHandle DeadlineTimerHandle;
+		uint32 Serial = 0;
+		int32 PendingSearches = 0;
+		bool bActive = false;
+		bool bJoinInFlight = false;
+		bool bCreateInFlight = false;
+		bool bDeadlinePassed = false;
+	};
+
+	void HandleQuickMatchSearch(const UE::Online::TOnlineResult<UE::Online::FFindLobbies>& FindLobbiesResult, uint32 Serial, int32 TierIndex);
+	/** 후보 중 하나에 참가를 시도합니다. 후보가 없고 더 기다릴 것도 없으면 로비 생성으로 넘어갑니다 */
+	void TryQuickMatchJoin();
+	void HandleQuickMatchDeadline();
+	void StartQuickMatchFallback();
+	void FinishQuickMatch(EQuickMatchResult Result, const FBlueprintLobbyInfo& LobbyInfo);
+	bool IsQuickMatchCandidate(const UE::Online::FLobby& Lobby) const;
+
+	FQuickMatchState QuickMatchState;
+
+	////////////////////////////////////////////////////////
+	/// 참가 재시도/페일오버
+
+	struct FJoinFailoverState
+	{
+		TWeakObjectPtr<ULocalPlayer> LocalPlayer;
+		/** 시작할 때 찍어둔 후보. 도중에 FoundLobbies가 바뀌어도 영향받지 않습니다 */
+		TArray<TSharedRef<const UE::Online::FLobby>> Candidates;
+		TArray<FBlueprintLobbyJoinAttempt> Attempts;
+		/** 지연 재시도와 다음 틱 재시도 모두 이 핸들로 걸고, FinishJoinLobbyWithFailover에서 지웁니다 */
+		FTimerHandle RetryTimerHandle;
+		double AttemptStartTime = 0.0;
+		int32 CandidateIndex = 0;
+		int32 RetryIndex = 0;
+		uint32 Serial = 0;
+		bool bActive = false;
+	};
+
+	void SendFailoverJoin();
+	void HandleFailoverJoin(const UE::Online::TOnlineResult<UE::Online::FJoinLobby>& JoinLobbyResult, uint32 Serial, UE::Online::FAccountId LocalAccountId);
+	void FinishJoinLobbyWithFailover(bool bSucceeded, const FBlueprintLobbyInfo& LobbyInfo);
+	/** 같은 로비에 다시 보내볼 만한 오류인지. 나머지는 다음 후보로 넘어갑니다 */
+	static bool IsTransientJoinError(const UE::Online::FOnlineError& Error);
+
+	FJoinFailoverState JoinFailoverState;
+
+	////////////////////////////////////////////////////////
+	/// 친구 로비 참가
+
+	struct FJoinFriendState
+	{
+		TWeakObjectPtr<ULocalPlayer> LocalPlayer;
+		UE::Online::FAccountId FriendAccountId;
+		uint32 Serial = 0;
+		bool bUsedSearch = false;
+		bool bActive = false;
+	};
+
+	/** 이미 받아둔 로비 중 친구가 들어있는 로비를 찾습니다. 마지막 검색 결과, 검색 캐시 순서로 봅니다 */
+	TSharedPtr<const UE::Online::FLobby> FindKnownFriendLobby(const UE::Online::FAccountId& FriendAccountId) const;
+	void SendFriendLobbyJoin(const TSharedRef<const UE::Online::FLobby>& Lobby);
+	/** 친구를 대상으로 로비를 검색하고 찾은 로비에 바로 참가합니다 */
+	void SearchFriendLobby();
+	void FinishJoinFriendLobby(bool bSucceeded, const FBlueprintLobbyInfo& LobbyInfo);
+
+	FJoinFriendState JoinFriendState;
+
+	////////////////////////////////////////////////////////
+	/// 레벨 미리 읽기
+
+	/** 이동할 레벨을 MAPNAME 값으로 바꿉니다. 별칭이 없고 경로가 스키마의 MaxSize보다 길면 로그를 남기고 false */
+	bool MakeLobbyMapName(const TSoftObjectPtr<UWorld>& LevelToTravel, FString& OutMapName) const;
+	/** MAPNAME을 레벨 경로로 바꿉니다. 긴 패키지 이름이나 LobbyMapAliases의 별칭을 받습니다 */
+	FSoftObjectPath ResolveLobbyMapPath(const UE::Online::FLobby& Lobby) const;
+	/** 미리 읽은 레벨로 이동을 마쳤으면 핸들을 놓아 이후 GC가 정리할 수 있게 합니다 */
+	void HandlePostLoadMapForPreload(UWorld* LoadedWorld);
+
+	TSharedPtr<FStreamableHandle> LobbyMapPreloadHandle;
+	FSoftObjectPath PreloadedLobbyMapPath;
+	FDelegateHandle PostLoadMapHandle;
+
+	////////////////////////////////////////////////////////
+	/// 호스트 게임 시작
+
+	/** 마지막으로 만든 로비가 이동할 레벨. 미리 읽기에만 쓰고, 실제 이동할 레벨은 로비의 MAPNAME으로 정합니다 */
+	TSoftObjectPtr<UWorld> HostLevelToTravel;
+	TSharedPtr<FStreamableHandle> HostMapPreloadHandle;
+
+	struct FHostStartState
+	{
+		FString TravelURL;
+		FHostStartTimings Timings;
+		double StartTime = 0.0;
+		uint32 Serial = 0;
+		bool bActive = false;
+		bool bMapLoaded = false;
+		bool bAnnounced = false;
+	};
+
+	/** 레벨 로드와 속성 알림이 둘 다 끝났으면 ServerTravel합니다 */
+	void TryFinishHostStart();
+	
+	FHostStartState HostStartState;
 	
 
 	UPROPERTY(BlueprintReadOnly)
@@ -394,10 +1539,51 @@ protected:
 	UPROPERTY(BlueprintReadOnly)
 	FBlueprintLobbyInfo JoinedLobby;
 	
-	UPROPERTY(BlueprintReadOnly)
-	TMap<int32, FBlueprintFriendInfo> FoundFriends;
+	/** 친구 목록. 블루프린트에서는 GetFriendInfos/GetFriendInfo로 읽습니다 */
+	FOnlineSampleFriendRoster FriendRoster;
 	
 	TSharedPtr<const UE::Online::FLobby> CreatedLobby = nullptr;
+
+	/** 페이지 검색 커서. 한 번 받은 검색 결과를 들고 있다가 페이지마다 다음 PageSize개를 넘깁니다 */
+	struct FLobbySearchCursor
+	{
+		/** 아직 FoundLobbies에 붙이지 않은 결과까지 포함한 검색 결과 전체 */
+		TArray<TSharedRef<const UE::Online::FLobby>> Results;
+		int32 NextResultIndex = 0;
+
+		int32 PageSize = 0;
+		int32 NextPageIndex = 0;
+		bool bSearchInFlight = false;
+		bool bExhausted = true;
+		bool bAutoStream = false;
+	};
+	FLobbySearchCursor LobbySearchCursor;
+
+	/** 새 로비 검색을 시작합니다. 페이지 커서를 멈추고 공용 시리얼을 올려 이전 검색의 응답이 FoundLobbies를 덮지 않게 합니다 */
+	uint32 BeginLobbySearch();
+	/** 모든 로비 검색이 같이 쓰는 시리얼. 응답은 자기 시리얼이 이 값과 같을 때만 FoundLobbies에 반영합니다 */
+	uint32 LobbySearchSerial = 0;
+
+	/** 로비 검색 캐시 항목 */
+	struct FLobbySearchCacheEntry
+	{
+		TArray<FBlueprintLobbyInfo> Results;
+		double FetchedTime = 0.0;
+		/** 이 항목의 응답을 기다리는 가장 최근 검색의 시리얼 */
+		uint32 SearchSerial = 0;
+		/** 그 검색에 캐시된 결과를 이미 보여줬는지 */
+		bool bServedFromCache = false;
+		bool bRefreshInFlight = false;
+	};
+
+	/** 정규화한 검색 파라미터(필터, 대상 유저, 최대 결과 수)로 캐시 키를 만듭니다 */
+	static FString MakeLobbySearchCacheKey(const UE::Online::FFindLobbies::Params& FindLobbyParams);
+	/** LobbySearchCacheMaxAgeSeconds가 지난 항목을 지웁니다 */
+	void PruneLobbySearchCache();
+	
+	TMap<FString, FLobbySearchCacheEntry> LobbySearchCache;
+	/** 지금 FoundLobbies가 어느 캐시 항목의 결과인지. QoS 정렬이 끝나면 정렬된 목록을 이 항목에 다시 넣습니다 */
+	FString FoundLobbiesCacheKey;
 	//TSharedPtr<const UE::Online::FLobby> JoinedLobby = nullptr;
 
 	UPROPERTY(BlueprintReadOnly)
@@ -0,0 +1,249 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "OnlineSampleQosProbe.h"
+
+#include "Common/UdpSocketBuilder.h"
+#include "Interfaces/IPv4/IPv4Endpoint.h"
+#include "Sockets.h"
+#include "SocketSubsystem.h"
+
+namespace OnlineSampleQos
+{
+	static void WritePacket(uint8* Packet, uint32 Session, uint32 Sequence)
+	{
+		const uint32 Magic = PacketMagic;
+		FMemory::Memcpy(Packet, &Magic, 4);
+		FMemory::Memcpy(Packet + 4, &Session, 4);
+		FMemory::Memcpy(Packet + 8, &Sequence, 4);
+	}
+
+	static bool ReadPacket(const uint8* Packet, int32 Size, uint32& OutSession, uint32& OutSequence)
+	{
+		uint32 Magic = 0;
+		if(Size != PacketSize)
+		{
+			return false;
+		}
+		FMemory::Memcpy(&Magic, Packet, 4);
+		FMemory::Memcpy(&OutSession, Packet + 4, 4);
+		FMemory::Memcpy(&OutSequence, Packet + 8, 4);
+		return Magic == PacketMagic;
+	}
+
+	/** 받은 즉시 처리하도록 짧게 기다립니다. 멈출 때 수신 스레드를 기다리는 시간도 이만큼입니다 */
+	static const FTimespan ReceiveWaitTime = FTimespan::FromMilliseconds(20);
+
+	static void StartReceiver(FSocket* Socket, const TCHAR* ThreadName, TUniquePtr<FUdpSocketReceiver>& OutReceiver, FOnSocketDataReceived&& OnDataReceived)
+	{
+		OutReceiver = MakeUnique<FUdpSocketReceiver>(Socket, ReceiveWaitTime, ThreadName);
+		OutReceiver->OnDataReceived() = MoveTemp(OnDataReceived);
+		OutReceiver->Start();
+	}
+
+	/** 소켓을 쓰는 수신 스레드를 먼저 멈추고 소켓을 닫습니다 */
+	static void DestroySocket(FSocket*& Socket, TUniquePtr<FUdpSocketReceiver>& Receiver)
+	{
+		Receiver.Reset();
+		if(Socket)
+		{
+			Socket->Close();
+			ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM)->DestroySocket(Socket);
+			Socket = nullptr;
+		}
+	}
+}
+
+FOnlineSampleQosResponder::~FOnlineSampleQosResponder()
+{
+	Stop();
+}
+
+bool FOnlineSampleQosResponder::Start(int32 Port)
+{
+	Stop();
+	
+	Socket = FUdpSocketBuilder(TEXT("OnlineSampleQosResponder"))
+		.AsNonBlocking()
+		.AsReusable()
+		.BoundToEndpoint(FIPv4Endpoint(FIPv4Address::Any, Port))
+		.Build();
+	if(!Socket)
+	{
+		return false;
+	}
+
+	OnlineSampleQos::StartReceiver(Socket, TEXT("OnlineSampleQosResponder"), Receiver,
+		FOnSocketDataReceived::CreateRaw(this, &FOnlineSampleQosResponder::HandleDataReceived));
+	return true;
+}
+
+void FOnlineSampleQosResponder::Stop()
+{
+	OnlineSampleQos::DestroySocket(Socket, Receiver);
+}
+
+int32 FOnlineSampleQosResponder::GetBoundPort() const
+{
+	return Socket ? Socket->GetPortNo() : 0;
+}
+
+FString FOnlineSampleQosResponder::GetHostAddressString() const
+{
+	ISocketSubsystem* SocketSubsystem = ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM);
+	bool bCanBindAll = false;
+	TSharedPtr<FInternetAddr> LocalAddr = SocketSubsystem->GetLocalHostAddr(*GLog, bCanBindAll);
+	if(!LocalAddr.IsValid() || !Socket)
+	{
+		return FString();
+	}
+	
+	return FString::Printf(TEXT("%s:%d"), *LocalAddr->ToString(false), GetBoundPort());
+}
+
+void FOnlineSampleQosResponder::HandleDataReceived(const FArrayReaderPtr& Data, const FIPv4Endpoint& Sender)
+{
+	// 다음 프레임을 기다리지 않고 받은 스레드에서 바로 돌려보냅니다.
+	uint32 Session = 0;
+	uint32 Sequence = 0;
+	if(OnlineSampleQos::ReadPacket(Data->GetData(), Data->Num(), Session, Sequence))
+	{
+		int32 BytesSent = 0;
+		Socket->SendTo(Data->GetData(), Data->Num(), BytesSent, *Sender.ToInternetAddr());
+	}
+}
+
+FOnlineSampleQosProber::~FOnlineSampleQosProber()
+{
+	OnProbeComplete = nullptr;
+	OnlineSampleQos::DestroySocket(Socket, Receiver);
+}
+
+bool FOnlineSampleQosProber::Start(const TArray<FString>& HostAddresses, int32 PingsPerHost, float TimeoutSeconds, FOnProbeComplete&& OnComplete)
+{
+	Cancel();
+	
+	ISocketSubsystem* SocketSubsystem = ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM);
+	Socket = FUdpSocketBuilder(TEXT("OnlineSampleQosProber"))
+		.AsNonBlocking()
+		.BoundToPort(0)
+		.Build();
+	if(!Socket)
+	{
+		return false;
+	}
+
+	OnProbeComplete = MoveTemp(OnComplete);
+	NumPingsPerHost = FMath::Max(PingsPerHost, 1);
+	ProbeSession = FMath::Rand();
+	DeadlineTime = FPlatformTime::Seconds() + TimeoutSeconds;
+
+	// 첫 응답이 소켓에서 기다리지 않도록 보내기 전에 수신 스레드를 띄웁니다.
+	OnlineSampleQos::StartReceiver(Socket, TEXT("OnlineSampleQosProber"), Receiver,
+		FOnSocketDataReceived::CreateRaw(this, &FOnlineSampleQosProber::HandleDataReceived));
+	
+	HostAddrs.Reset(HostAddresses.Num());
+	BestRttMs.Init(-1.f, HostAddresses.Num());
+	SendTimes.Init(0.0, HostAddresses.Num() * NumPingsPerHost);
+	NumPendingReplies = 0;
+
+	// 모든 호스트에 한꺼번에 보내므로 전체 시간은 가장 느린 호스트 하나로 끝납니다.
+	uint8 Packet[OnlineSampleQos::PacketSize];
+	for(int32 HostIndex = 0; HostIndex < HostAddresses.Num(); ++HostIndex)
+	{
+		FIPv4Endpoint Endpoint;
+		if(!FIPv4Endpoint::Parse(HostAddresses[HostIndex], Endpoint))
+		{
+			HostAddrs.Add(nullptr);
+			continue;
+		}
+
+		TSharedRef<FInternetAddr> HostAddr = Endpoint.ToInternetAddr();
+		HostAddrs.Add(HostAddr);
+		for(int32 PingIndex = 0; PingIndex < NumPingsPerHost; ++PingIndex)
+		{
+			const uint32 Sequence = HostIndex * NumPingsPerHost + PingIndex;
+			OnlineSampleQos::WritePacket(Packet, ProbeSession, Sequence);
+			
+			int32 BytesSent = 0;
+			SendTimes[Sequence] = FPlatformTime::Seconds();
+			if(Socket->SendTo(Packet, sizeof(Packet), BytesSent, *HostAddr))
+			{
+				++NumPendingReplies;
+			}
+		}
+	}
+
+	if(NumPendingReplies == 0)
+	{
+		Finish();
+	}
+	return true;
+}
+
+void FOnlineSampleQosProber::Cancel()
+{
+	OnProbeComplete = nullptr;
+	OnlineSampleQos::DestroySocket(Socket, Receiver);
+	ReceivedReplies.Empty();
+}
+
+void FOnlineSampleQosProber::HandleDataReceived(const FArrayReaderPtr& Data, const FIPv4Endpoint& Sender)
+{
+	// 게임 스레드 틱을 기다리면 프레임 시간만큼 RTT가 늘어나므로 여기서 시각을 찍습니다.
+	const double ReceiveTime = FPlatformTime::Seconds();
+	uint32 Session = 0;
+	uint32 Sequence = 0;
+	if(OnlineSampleQos::ReadPacket(Data->GetData(), Data->Num(), Session, Sequence) && Session == ProbeSession)
+	{
+		ReceivedReplies.Enqueue(FReceivedReply{ Sequence, ReceiveTime });
+	}
+}
+
+bool FOnlineSampleQosProber::Tick(float DeltaTime)
+{
+	if(!Socket)
+	{
+		return true;
+	}
+
+	FReceivedReply Reply;
+	while(Socket && ReceivedReplies.Dequeue(Reply))
+	{
+		const uint32 Sequence = Reply.Sequence;
+		if(!SendTimes.IsValidIndex(Sequence) || SendTimes[Sequence] == 0.0)
+		{
+			continue;
+		}
+
+		const int32 HostIndex = Sequence / NumPingsPerHost;
+		const float RttMs = static_cast<float>((Reply.ReceiveTime - SendTimes[Sequence]) * 1000.0);
+		BestRttMs[HostIndex] = BestRttMs[HostIndex] < 0.f ? RttMs : FMath::Min(BestRttMs[HostIndex], RttMs);
+
+		// 같은 응답이 두 번 세어지지 않도록 지웁니다.
+		SendTimes[Sequence] = 0.0;
+		if(--NumPendingReplies == 0)
+		{
+			Finish();
+		}
+	}
+
+	if(Socket && FPlatformTime::Seconds() >= DeadlineTime)
+	{
+		Finish();
+	}
+	return true;
+}
+
+void FOnlineSampleQosProber::Finish()
+{
+	OnlineSampleQos::DestroySocket(Socket, Receiver);
+	ReceivedReplies.Empty();
+	
+	if(OnProbeComplete)
+	{
+		FOnProbeComplete Callback = MoveTemp(OnProbeComplete);
+		OnProbeComplete = nullptr;
+		Callback(BestRttMs);
+	}
+}
@@ -0,0 +1,97 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Containers/Queue.h"
+#include "Containers/Ticker.h"
+#include "Common/UdpSocketReceiver.h"
+
+class FSocket;
+class ISocketSubsystem;
+
+/**
+ * 아주 작은 UDP 에코 프로토콜입니다.
+ *		패킷은 매직(4) + 프로브 세션 번호(4) + 시퀀스(4) 12바이트이고, 응답자는 받은 그대로 돌려보냅니다
+ */
+namespace OnlineSampleQos
+{
+	constexpr uint32 PacketMagic = 0x5053514F; // 'OQSP'
+	constexpr int32 PacketSize = 12;
+}
+
+/**
+ * 호스트에서 도는 QoS 에코 응답자입니다.
+ *		FUdpSocketReceiver 스레드에서 받는 즉시 돌려보내므로 호스트의 프레임 시간이 RTT에 섞이지 않습니다
+ */
+class ONLINETESTSAMPLE_API FOnlineSampleQosResponder
+{
+public:
+
+	~FOnlineSampleQosResponder();
+
+	/** 포트에 바인드합니다. 0이면 빈 포트를 씁니다 */
+	bool Start(int32 Port);
+	void Stop();
+
+	bool IsRunning() const { return Socket != nullptr; }
+	int32 GetBoundPort() const;
+
+	/** 다른 호스트가 접속할 "IP:Port" 주소입니다 */
+	FString GetHostAddressString() const;
+
+private:
+
+	/** 수신 스레드에서 불립니다 */
+	void HandleDataReceived(const FArrayReaderPtr& Data, const FIPv4Endpoint& Sender);
+
+	FSocket* Socket = nullptr;
+	TUniquePtr<FUdpSocketReceiver> Receiver;
+};
+
+/**
+ * 여러 호스트에 동시에 에코를 보내고 호스트별 최소 RTT(ms)를 잽니다.
+ *		받은 시각은 FUdpSocketReceiver 스레드에서 받자마자 찍고, 코어 티커는 결과를 모으기만 합니다.
+ *		응답이 없는 호스트는 -1입니다
+ */
+class ONLINETESTSAMPLE_API FOnlineSampleQosProber : public FTSTickerObjectBase
+{
+public:
+
+	using FOnProbeComplete = TFunction<void(const TArray<float>& RttMs)>;
+
+	virtual ~FOnlineSampleQosProber() override;
+
+	/** 각 주소("IP:Port")에 PingsPerHost개씩 보내고 TimeoutSeconds 안에 온 응답만 셉니다 */
+	bool Start(const TArray<FString>& HostAddresses, int32 PingsPerHost, float TimeoutSeconds, FOnProbeComplete&& OnComplete);
+	void Cancel();
+
+	bool IsRunning() const { return Socket != nullptr; }
+
+	virtual bool Tick(float DeltaTime) override;
+
+private:
+
+	struct FReceivedReply
+	{
+		uint32 Sequence = 0;
+		double ReceiveTime = 0.0;
+	};
+
+	/** 수신 스레드에서 불립니다. 받은 시각만 찍어 큐에 넣습니다 */
+	void HandleDataReceived(const FArrayReaderPtr& Data, const FIPv4Endpoint& Sender);
+	void Finish();
+
+	FSocket* Socket = nullptr;
+	TUniquePtr<FUdpSocketReceiver> Receiver;
+	/** 수신 스레드가 넣고 코어 티커가 꺼냅니다 */
+	TQueue<FReceivedReply, EQueueMode::Spsc> ReceivedReplies;
+	TArray<TSharedPtr<class FInternetAddr>> HostAddrs;
+	TArray<double> SendTimes;
+	TArray<float> BestRttMs;
+	int32 NumPingsPerHost = 0;
+	int32 NumPendingReplies = 0;
+	uint32 ProbeSession = 0;
+	double DeadlineTime = 0.0;
+	FOnProbeComplete OnProbeComplete;
+};
@@ -9,7 +9,7 @@ public class OnlineTestSample : ModuleRules
 		PCHUsage = PCHUsageMode.UseExplicitOrSharedPCHs;
 	
 		PublicDependencyModuleNames.AddRange(new string[] { "Core", "CoreUObject", "Engine", "InputCore", "EnhancedInput", 
-			"OnlineServicesInterface", "CoreOnline"  });
+			"OnlineServicesInterface", "CoreOnline", "Sockets", "Networking"  });
 
 		//PrivateDependencyModuleNames.AddRange(new string[] {"OnlineServicesEOSGS"});
 
@@ -29,8 +29,16 @@ void AOnlineSamplePlayerController::BeginPlay()
 			UE_LOG(LogOnlineSampleOnlineSubsystem, Log, TEXT("Registering PlatformUserId: %d"), LocalPlayerPlatformUserId.GetInternalId());
 			// OnlineSubsystem->RegisterLocalOnlineUser(LocalPlayerPlatformUserId);
 			
-			//로그인 부분 임시.
-			OnlineSubsystem->Login(LocalPlayerPlatformUserId);
+			// 첫 번째 플레이어가 스플릿스크린 플레이어 전원을 한꺼번에 로그인합니다.
+			// 나중에 추가된 플레이어는 자기만 로그인하고, 진행 중인 로그인은 Login이 알아서 합칩니다.
+			if(LocalPlayer->IsPrimaryPlayer())
+			{
+				OnlineSubsystem->LoginAllLocalPlayers();
+			}
+			else if(!OnlineSubsystem->IsLoggedIn(LocalPlayer))
+			{
+				OnlineSubsystem->Login(LocalPlayerPlatformUserId);
+			}
 			
 			
 			// // 타이틀 파일을 읽고 화면에 콘텐츠를 표시합니다
@@ -46,4 +54,19 @@ void AOnlineSamplePlayerController::BeginPlay()
 void AOnlineSamplePlayerController::EndPlay(EEndPlayReason::Type EndReason)
 {
 	Super::EndPlay(EndReason);
+}
+
+void AOnlineSamplePlayerController::NotifyLoadedWorld(FName WorldPackageName, bool bFinalDest)
+{
+	Super::NotifyLoadedWorld(WorldPackageName, bFinalDest);
+
+	if(!bFinalDest || !IsLocalController())
+	{
+		return;
+	}
+
+	if(UOnlineSampleOnlineSubsystem* OnlineSubsystem = GetGameInstance()->GetSubsystem<UOnlineSampleOnlineSubsystem>())
+	{
+		OnlineSubsystem->HandleSeamlessTravelComplete(GetLocalPlayer());
+	}
 }
\ No newline at end of file
@@ -21,4 +21,8 @@ protected:
 
 	virtual void BeginPlay() override;
 	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+public:
+	/** 심리스 트래블은 컨트롤러를 새로 만들지 않아 BeginPlay가 다시 오지 않으므로, 도착을 여기서 서브시스템에 알립니다 */
+	virtual void NotifyLoadedWorld(FName WorldPackageName, bool bFinalDest) override;
 };